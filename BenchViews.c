@@ -0,0 +1,22 @@
+#include <stdlib.h>
+
+#include "BenchViews.h"
+
+const benchView benchViews[] = {
+   { "overview",    { -0.5,                0.0               },  8, 512, 512,  255 },
+   { "interior",    { -0.1,                0.0               }, 12, 512, 512, 1000 },
+   { "exterior",    {  1.5,                1.5               },  8, 512, 512, 1000 },
+   { "seahorse",    { -0.743643887037151,  0.131825904205330 }, 16, 512, 512, 2000 },
+   { "minibrot",    { -1.768778833,       -0.001738996       }, 28, 512, 512, 4000 },
+   { "deep",        { -0.743643887037151,  0.131825904205330 }, 40, 512, 512, 5000 },
+};
+
+const int benchViewCount = sizeof benchViews / sizeof benchViews[0];
+
+MandelbrotSet BenchViews_create(const benchView *view) {
+   MandelbrotSet fractal = createMandelbrotSet(view->width, view->height);
+   MandelbrotSet_setMaxIterations(fractal, view->maxIterations);
+   MandelbrotSet_setPosition(fractal, view->center, view->zoom);
+
+   return fractal;
+}
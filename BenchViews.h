@@ -0,0 +1,24 @@
+#ifndef BENCH_VIEWS_H
+#define BENCH_VIEWS_H
+
+#include "MandelbrotSet.h"
+
+// A fixed catalogue of views covering the cases the generators behave
+// differently on: mostly interior, mostly exterior, boundary detail and deep zooms
+
+typedef struct {
+   const char *name;
+   mandelbrotCoord center;
+   int zoom;
+   int width;
+   int height;
+   int maxIterations;
+} benchView;
+
+extern const benchView benchViews[];
+extern const int benchViewCount;
+
+// a fractal sized and positioned for the view (free with freeMandelbrotSet)
+MandelbrotSet BenchViews_create(const benchView *view);
+
+#endif
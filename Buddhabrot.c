@@ -0,0 +1,523 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "Buddhabrot.h"
+
+// c is sampled from [-SAMPLE_EXTENT, SAMPLE_EXTENT] squared, outside it every orbit escapes at once
+#define SAMPLE_EXTENT 2.0
+#define ESCAPE_RADIUS_SQ 4.0
+
+// importance map: cells across the sampling square, and probe samples per cell
+#define IMPORTANCE_CELLS 128
+#define IMPORTANCE_PROBES 16
+
+// histogram tiles are HISTOGRAM_TILE pixels square
+#define HISTOGRAM_TILE 8
+
+// orbits iterated side by side, and iterations between checks for escaped lanes;
+// the inner loop is fixed length and branch free so the compiler can vectorize it
+#define ORBIT_LANES 8
+#define ORBIT_BLOCK 16
+
+#define NOT_ESCAPED -1
+
+struct buddhabrotData {
+   int width;
+   int height;
+   double left;
+   double top;
+   double resolution;
+
+   int minIterations;
+   int maxIterations;
+
+   // indices of the cells c is drawn from, rebuilt when the iteration range changes
+   int *activeCells;
+   int activeCellCount;
+   bool isMapped;
+
+   // the merged result, rows point into one block
+   uint32_t **density;
+
+   int tilesAcross;
+   int tilesDown;
+};
+
+typedef struct {
+   double cx[ORBIT_LANES];
+   double cy[ORBIT_LANES];
+   double x[ORBIT_LANES];
+   double y[ORBIT_LANES];
+   // iterations run before the current block
+   int iterations[ORBIT_LANES];
+   int escapedAt[ORBIT_LANES];
+   bool isActive[ORBIT_LANES];
+} orbitLanes;
+
+typedef struct {
+   Buddhabrot buddhabrot;
+   long long orbitCount;
+   uint64_t seed;
+   uint32_t *histogram;
+
+   pthread_mutex_t *lock;
+   pthread_cond_t *allDone;
+   int *remaining;
+} orbitTask;
+
+static void runOrbitTask(void *data);
+
+// advance every lane ORBIT_BLOCK iterations, noting the first escape of each
+static void iterateBlock(orbitLanes *lanes);
+
+// replay an escaping orbit, counting each point that lands in the image
+static void recordOrbit(Buddhabrot buddhabrot, uint32_t *histogram, double cx, double cy, int length);
+
+// draw c from the active cells, skipping points known to be inside the set
+static bool drawSample(Buddhabrot buddhabrot, uint64_t *state, double *cx, double *cy);
+static bool isKnownInterior(double cx, double cy);
+
+// probe every cell of the sampling square, keeping those that contribute
+static void buildImportanceMap(Buddhabrot buddhabrot);
+static int escapeIteration(double cx, double cy, int maxIterations);
+static bool orbitReachesImage(Buddhabrot buddhabrot, double cx, double cy, int length);
+
+static void mergeHistogram(Buddhabrot buddhabrot, const uint32_t *histogram);
+static size_t histogramIndex(Buddhabrot buddhabrot, int row, int col);
+
+// splitmix64, a fast generator with no correlation between nearby seeds
+static uint64_t nextRandom(uint64_t *state);
+static double nextUniform(uint64_t *state);
+
+
+Buddhabrot createBuddhabrot(int width, int height, mandelbrotCoord center, real resolution) {
+   int row;
+
+   Buddhabrot buddhabrot = malloc(sizeof (struct buddhabrotData));
+   assert(buddhabrot != NULL);
+
+   buddhabrot->width = width;
+   buddhabrot->height = height;
+   buddhabrot->resolution = (double)resolution;
+   buddhabrot->left = (double)(center.x - (width * resolution)/2.0);
+   buddhabrot->top = (double)(center.y + (height * resolution)/2.0);
+
+   buddhabrot->minIterations = 0;
+   buddhabrot->maxIterations = DEFAULT_MAX_ITERATIONS;
+
+   buddhabrot->activeCells = malloc(sizeof (int) * IMPORTANCE_CELLS * IMPORTANCE_CELLS);
+   assert(buddhabrot->activeCells != NULL);
+   buddhabrot->activeCellCount = 0;
+   buddhabrot->isMapped = false;
+
+   buddhabrot->density = malloc(sizeof (uint32_t *) * height);
+   assert(buddhabrot->density != NULL);
+   buddhabrot->density[0] = calloc((size_t)width * height, sizeof (uint32_t));
+   assert(buddhabrot->density[0] != NULL);
+   for (row = 1; row != height; ++row) {
+      buddhabrot->density[row] = buddhabrot->density[0] + (size_t)row * width;
+   }
+
+   buddhabrot->tilesAcross = (width + HISTOGRAM_TILE - 1) / HISTOGRAM_TILE;
+   buddhabrot->tilesDown = (height + HISTOGRAM_TILE - 1) / HISTOGRAM_TILE;
+
+   return buddhabrot;
+}
+
+void freeBuddhabrot(Buddhabrot buddhabrot) {
+   free(buddhabrot->density[0]);
+   free(buddhabrot->density);
+   free(buddhabrot->activeCells);
+   free(buddhabrot);
+}
+
+void Buddhabrot_setIterationRange(Buddhabrot buddhabrot, int minIterations, int maxIterations) {
+   assert(minIterations >= 0 && maxIterations > minIterations);
+
+   buddhabrot->minIterations = minIterations;
+   buddhabrot->maxIterations = maxIterations;
+   buddhabrot->isMapped = false;
+}
+
+void Buddhabrot_render(Buddhabrot buddhabrot, MandelbrotPool pool, long long orbitCount, uint64_t seed) {
+   int task;
+   int taskCount = MandelbrotPool_getThreadCount(pool);
+   int remaining = taskCount;
+   uint64_t seedState = seed;
+   uint64_t callKey = nextRandom(&seedState);
+   uint64_t taskState;
+   size_t histogramSize = (size_t)buddhabrot->tilesAcross * buddhabrot->tilesDown *
+                          HISTOGRAM_TILE * HISTOGRAM_TILE;
+   pthread_mutex_t lock;
+   pthread_cond_t allDone;
+
+   if (!buddhabrot->isMapped) {
+      buildImportanceMap(buddhabrot);
+   }
+   if (buddhabrot->activeCellCount == 0) {
+      // no orbit in range reaches the image
+      return;
+   }
+
+   orbitTask *tasks = malloc(sizeof (orbitTask) * taskCount);
+   assert(tasks != NULL);
+
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&allDone, NULL);
+
+   for (task = 0; task != taskCount; ++task) {
+      tasks[task].buddhabrot = buddhabrot;
+      // spread the remainder over the first tasks
+      tasks[task].orbitCount = orbitCount / taskCount + (task < orbitCount % taskCount ? 1 : 0);
+      // each task's stream starts at a hash of the seed and task, not seed + task,
+      // which would make task k of seed s + 1 replay task k + 1 of seed s
+      taskState = callKey + (uint64_t)task;
+      tasks[task].seed = nextRandom(&taskState);
+      tasks[task].histogram = calloc(histogramSize, sizeof (uint32_t));
+      assert(tasks[task].histogram != NULL);
+      tasks[task].lock = &lock;
+      tasks[task].allDone = &allDone;
+      tasks[task].remaining = &remaining;
+
+      MandelbrotPool_submit(pool, runOrbitTask, &tasks[task]);
+   }
+
+   pthread_mutex_lock(&lock);
+   while (remaining > 0) {
+      pthread_cond_wait(&allDone, &lock);
+   }
+   pthread_mutex_unlock(&lock);
+
+   for (task = 0; task != taskCount; ++task) {
+      mergeHistogram(buddhabrot, tasks[task].histogram);
+      free(tasks[task].histogram);
+   }
+
+   pthread_cond_destroy(&allDone);
+   pthread_mutex_destroy(&lock);
+   free(tasks);
+}
+
+uint32_t **Buddhabrot_getDensity(Buddhabrot buddhabrot) {
+   return buddhabrot->density;
+}
+
+uint32_t Buddhabrot_getMaxDensity(Buddhabrot buddhabrot) {
+   size_t index;
+   size_t size = (size_t)buddhabrot->width * buddhabrot->height;
+   uint32_t maxDensity = 0;
+
+   for (index = 0; index != size; ++index) {
+      if (buddhabrot->density[0][index] > maxDensity) {
+         maxDensity = buddhabrot->density[0][index];
+      }
+   }
+
+   return maxDensity;
+}
+
+double Buddhabrot_getSampledFraction(Buddhabrot buddhabrot) {
+   if (!buddhabrot->isMapped) {
+      buildImportanceMap(buddhabrot);
+   }
+
+   return (double)buddhabrot->activeCellCount / (IMPORTANCE_CELLS * IMPORTANCE_CELLS);
+}
+
+
+// Static functions
+
+static void runOrbitTask(void *data) {
+   orbitTask *task = data;
+   Buddhabrot buddhabrot = task->buddhabrot;
+   orbitLanes lanes;
+   long long drawn = 0;
+   int lane;
+   int activeLanes = 0;
+   int escapedAt;
+   uint64_t state = task->seed;
+
+   // start every lane on a fresh orbit
+   for (lane = 0; lane != ORBIT_LANES; ++lane) {
+      lanes.x[lane] = 0;
+      lanes.y[lane] = 0;
+      lanes.iterations[lane] = 0;
+      lanes.escapedAt[lane] = NOT_ESCAPED;
+      lanes.isActive[lane] = false;
+
+      while (!lanes.isActive[lane] && drawn < task->orbitCount) {
+         drawn++;
+         lanes.isActive[lane] = drawSample(buddhabrot, &state, &lanes.cx[lane], &lanes.cy[lane]);
+      }
+      if (lanes.isActive[lane]) {
+         activeLanes++;
+      } else {
+         // parked on c = 0, which stays bounded and finite
+         lanes.cx[lane] = 0;
+         lanes.cy[lane] = 0;
+      }
+   }
+
+   while (activeLanes > 0) {
+      iterateBlock(&lanes);
+
+      for (lane = 0; lane != ORBIT_LANES; ++lane) {
+         lanes.iterations[lane] += ORBIT_BLOCK;
+         escapedAt = lanes.escapedAt[lane];
+
+         if (!lanes.isActive[lane] ||
+             (escapedAt == NOT_ESCAPED && lanes.iterations[lane] < buddhabrot->maxIterations)) {
+            // still running
+            continue;
+         }
+
+         if (escapedAt != NOT_ESCAPED && escapedAt >= buddhabrot->minIterations &&
+             escapedAt < buddhabrot->maxIterations) {
+            recordOrbit(buddhabrot, task->histogram, lanes.cx[lane], lanes.cy[lane], escapedAt);
+         }
+
+         // refill the lane, or park it once this task's samples are used up
+         lanes.x[lane] = 0;
+         lanes.y[lane] = 0;
+         lanes.iterations[lane] = 0;
+         lanes.escapedAt[lane] = NOT_ESCAPED;
+         lanes.isActive[lane] = false;
+         while (!lanes.isActive[lane] && drawn < task->orbitCount) {
+            drawn++;
+            lanes.isActive[lane] = drawSample(buddhabrot, &state, &lanes.cx[lane], &lanes.cy[lane]);
+         }
+         if (!lanes.isActive[lane]) {
+            lanes.cx[lane] = 0;
+            lanes.cy[lane] = 0;
+            activeLanes--;
+         }
+      }
+   }
+
+   pthread_mutex_lock(task->lock);
+   (*task->remaining)--;
+   if (*task->remaining == 0) {
+      pthread_cond_signal(task->allDone);
+   }
+   pthread_mutex_unlock(task->lock);
+}
+
+static void iterateBlock(orbitLanes *lanes) {
+   int step, lane;
+   double x, y, xSq, ySq;
+   bool hasEscaped;
+
+   for (step = 1; step <= ORBIT_BLOCK; ++step) {
+      for (lane = 0; lane != ORBIT_LANES; ++lane) {
+         x = lanes->x[lane];
+         y = lanes->y[lane];
+         xSq = x*x;
+         ySq = y*y;
+
+         lanes->y[lane] = 2*x*y + lanes->cy[lane];
+         lanes->x[lane] = xSq - ySq + lanes->cx[lane];
+
+         // escaped lanes keep iterating (towards infinity) until the block ends,
+         // only their first escape counts
+         hasEscaped = (lanes->x[lane]*lanes->x[lane] + lanes->y[lane]*lanes->y[lane] >= ESCAPE_RADIUS_SQ);
+         lanes->escapedAt[lane] = (hasEscaped && lanes->escapedAt[lane] == NOT_ESCAPED)
+                                  ? lanes->iterations[lane] + step : lanes->escapedAt[lane];
+      }
+   }
+}
+
+static void recordOrbit(Buddhabrot buddhabrot, uint32_t *histogram, double cx, double cy, int length) {
+   int step, row, col;
+   double x = 0;
+   double y = 0;
+   double tempX;
+   double rowPosition, colPosition;
+   size_t bin;
+
+   for (step = 0; step != length; ++step) {
+      tempX = x*x - y*y + cx;
+      y = 2*x*y + cy;
+      x = tempX;
+
+      colPosition = (x - buddhabrot->left) / buddhabrot->resolution;
+      rowPosition = (buddhabrot->top - y) / buddhabrot->resolution;
+      if (colPosition >= 0 && colPosition < buddhabrot->width &&
+          rowPosition >= 0 && rowPosition < buddhabrot->height) {
+         row = (int)rowPosition;
+         col = (int)colPosition;
+         bin = histogramIndex(buddhabrot, row, col);
+         // one task can pass a bright pixel 2^32 times on a long render, so saturate
+         // here too, or the count wraps to near zero before the merge ever sees it
+         if (histogram[bin] != UINT32_MAX) {
+            histogram[bin]++;
+         }
+      }
+   }
+}
+
+static bool drawSample(Buddhabrot buddhabrot, uint64_t *state, double *cx, double *cy) {
+   double cellSize = 2*SAMPLE_EXTENT / IMPORTANCE_CELLS;
+   int cell = buddhabrot->activeCells[nextRandom(state) % buddhabrot->activeCellCount];
+
+   *cx = -SAMPLE_EXTENT + ((cell % IMPORTANCE_CELLS) + nextUniform(state)) * cellSize;
+   *cy = -SAMPLE_EXTENT + ((cell / IMPORTANCE_CELLS) + nextUniform(state)) * cellSize;
+
+   return !isKnownInterior(*cx, *cy);
+}
+
+static bool isKnownInterior(double cx, double cy) {
+   // main cardioid, the same test escapeScore uses
+   double xShifted = cx - 0.25;
+   double ySq = cy*cy;
+   double q = xShifted*xShifted + ySq;
+
+   // period-2 bulb, the disc of radius 1/4 around -1
+   double xBulb = cx + 1;
+
+   return (q * (q + xShifted) < 0.25 * ySq) || (xBulb*xBulb + ySq < 0.0625);
+}
+
+static void buildImportanceMap(Buddhabrot buddhabrot) {
+   int cellRow, cellCol, probe;
+   int neighbourRow, neighbourCol;
+   int escapedAt;
+   bool hasInside, hasOutside, isNearUseful;
+   double cellSize = 2*SAMPLE_EXTENT / IMPORTANCE_CELLS;
+   double cx, cy;
+   uint64_t state = 0;
+
+   bool *isUseful = calloc(IMPORTANCE_CELLS * IMPORTANCE_CELLS, sizeof (bool));
+   assert(isUseful != NULL);
+
+   for (cellRow = 0; cellRow != IMPORTANCE_CELLS; ++cellRow) {
+      for (cellCol = 0; cellCol != IMPORTANCE_CELLS; ++cellCol) {
+         hasInside = false;
+         hasOutside = false;
+
+         for (probe = 0; probe != IMPORTANCE_PROBES && !isUseful[cellRow * IMPORTANCE_CELLS + cellCol]; ++probe) {
+            cx = -SAMPLE_EXTENT + (cellCol + nextUniform(&state)) * cellSize;
+            cy = -SAMPLE_EXTENT + (cellRow + nextUniform(&state)) * cellSize;
+
+            if (isKnownInterior(cx, cy)) {
+               hasInside = true;
+               continue;
+            }
+
+            escapedAt = escapeIteration(cx, cy, buddhabrot->maxIterations);
+            if (escapedAt == NOT_ESCAPED) {
+               hasInside = true;
+            } else {
+               hasOutside = true;
+               if (escapedAt >= buddhabrot->minIterations &&
+                   orbitReachesImage(buddhabrot, cx, cy, escapedAt)) {
+                  isUseful[cellRow * IMPORTANCE_CELLS + cellCol] = true;
+               }
+            }
+         }
+
+         // cells straddling the boundary hold the long orbits even if no probe found one
+         if (hasInside && hasOutside) {
+            isUseful[cellRow * IMPORTANCE_CELLS + cellCol] = true;
+         }
+      }
+   }
+
+   // keep a margin of one cell, contributing regions rarely end exactly on a cell edge
+   buddhabrot->activeCellCount = 0;
+   for (cellRow = 0; cellRow != IMPORTANCE_CELLS; ++cellRow) {
+      for (cellCol = 0; cellCol != IMPORTANCE_CELLS; ++cellCol) {
+         isNearUseful = false;
+         for (neighbourRow = cellRow - 1; neighbourRow <= cellRow + 1; ++neighbourRow) {
+            for (neighbourCol = cellCol - 1; neighbourCol <= cellCol + 1; ++neighbourCol) {
+               if (neighbourRow >= 0 && neighbourRow < IMPORTANCE_CELLS &&
+                   neighbourCol >= 0 && neighbourCol < IMPORTANCE_CELLS &&
+                   isUseful[neighbourRow * IMPORTANCE_CELLS + neighbourCol]) {
+                  isNearUseful = true;
+               }
+            }
+         }
+         if (isNearUseful) {
+            buddhabrot->activeCells[buddhabrot->activeCellCount++] = cellRow * IMPORTANCE_CELLS + cellCol;
+         }
+      }
+   }
+
+   free(isUseful);
+   buddhabrot->isMapped = true;
+}
+
+static int escapeIteration(double cx, double cy, int maxIterations) {
+   int iteration;
+   double x = 0;
+   double y = 0;
+   double tempX;
+
+   for (iteration = 1; iteration <= maxIterations; ++iteration) {
+      tempX = x*x - y*y + cx;
+      y = 2*x*y + cy;
+      x = tempX;
+      if (x*x + y*y >= ESCAPE_RADIUS_SQ) {
+         return (iteration < maxIterations) ? iteration : NOT_ESCAPED;
+      }
+   }
+
+   return NOT_ESCAPED;
+}
+
+static bool orbitReachesImage(Buddhabrot buddhabrot, double cx, double cy, int length) {
+   int step;
+   double x = 0;
+   double y = 0;
+   double tempX;
+   double right = buddhabrot->left + buddhabrot->width * buddhabrot->resolution;
+   double bottom = buddhabrot->top - buddhabrot->height * buddhabrot->resolution;
+
+   for (step = 0; step != length; ++step) {
+      tempX = x*x - y*y + cx;
+      y = 2*x*y + cy;
+      x = tempX;
+      if (x >= buddhabrot->left && x < right && y <= buddhabrot->top && y > bottom) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+static void mergeHistogram(Buddhabrot buddhabrot, const uint32_t *histogram) {
+   int row, col;
+   uint32_t *density;
+   uint32_t count;
+
+   for (row = 0; row != buddhabrot->height; ++row) {
+      density = buddhabrot->density[row];
+      for (col = 0; col != buddhabrot->width; ++col) {
+         count = histogram[histogramIndex(buddhabrot, row, col)];
+         density[col] = (density[col] > UINT32_MAX - count) ? UINT32_MAX : density[col] + count;
+      }
+   }
+}
+
+static size_t histogramIndex(Buddhabrot buddhabrot, int row, int col) {
+   size_t tile = (size_t)(row / HISTOGRAM_TILE) * buddhabrot->tilesAcross + col / HISTOGRAM_TILE;
+
+   return tile * (HISTOGRAM_TILE * HISTOGRAM_TILE) + (row % HISTOGRAM_TILE) * HISTOGRAM_TILE + col % HISTOGRAM_TILE;
+}
+
+static uint64_t nextRandom(uint64_t *state) {
+   uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+   return z ^ (z >> 31);
+}
+
+static double nextUniform(uint64_t *state) {
+   // the top 53 bits, uniform in [0, 1)
+   return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
@@ -0,0 +1,49 @@
+#ifndef BUDDHABROT_H
+#define BUDDHABROT_H
+
+#include <stdint.h>
+
+#include "MandelbrotSet.h"
+#include "MandelbrotPool.h"
+
+// Orbit density (Buddhabrot) images: c is sampled over the plane and every point
+// visited by an orbit that escapes within the iteration range is counted.
+//
+// Sampling is importance driven: a coarse probe of the plane finds the cells
+// whose orbits can reach the image, and c is drawn uniformly from those only
+// (plus a one cell margin). Points inside the main cardioid or period-2 bulb
+// never escape and are dropped before iterating.
+//
+// Each pool task accumulates into its own histogram, stored in small square
+// tiles so the scattered hits of nearby orbit points share cache lines, and
+// the histograms are summed once the render finishes; no atomics per hit.
+
+typedef struct buddhabrotData *Buddhabrot;
+
+// the image viewport, as for MandelbrotSet_setView
+Buddhabrot createBuddhabrot(int width, int height, mandelbrotCoord center, real resolution);
+
+void freeBuddhabrot(Buddhabrot buddhabrot);
+
+// only orbits escaping after at least minIterations and fewer than maxIterations are counted
+// (a narrow high range gives the "anti-Buddhabrot" look, a wide low one the classic)
+void Buddhabrot_setIterationRange(Buddhabrot buddhabrot, int minIterations, int maxIterations);
+
+// draw orbitCount more samples of c, split across the pool, and add their orbits
+// to the density; repeated calls refine the same image
+// any seed is valid: distinct seeds draw independent samples whatever their values,
+// and the same seed with the same thread count draws the same ones again, so seed
+// each refining call differently
+void Buddhabrot_render(Buddhabrot buddhabrot, MandelbrotPool pool, long long orbitCount, uint64_t seed);
+
+// returns a borrowed reference, rows stored back to back like MandelbrotSet_getScores
+// counts saturate rather than wrap
+uint32_t **Buddhabrot_getDensity(Buddhabrot buddhabrot);
+
+uint32_t Buddhabrot_getMaxDensity(Buddhabrot buddhabrot);
+
+// fraction of the sampling square [-2, 2] x [-2, 2] that c is drawn from,
+// to compare densities rendered with different importance maps
+double Buddhabrot_getSampledFraction(Buddhabrot buddhabrot);
+
+#endif
@@ -0,0 +1,327 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "CheckpointRender.h"
+#include "FileIO.h"
+
+typedef struct {
+   uint32_t magic;
+   uint32_t tileCount;
+   checkpointJob job;
+} checkpointHeader;
+
+typedef struct {
+   RenderCluster cluster;
+   const checkpointJob *job;
+   const char *checkpointPath;
+   int outputFd;
+   int intervalSeconds;
+
+   clusterTile *tiles;
+   int tileCount;
+
+   // one bit per tile, set once its scores have been written
+   unsigned char *completed;
+   unsigned char *snapshot;
+   size_t bitmapSize;
+
+   // guards completed, isDirty, isFinished and hasFailed
+   pthread_mutex_t lock;
+   pthread_cond_t finished;
+   bool isDirty;
+   bool isFinished;
+   bool hasFailed;
+} renderState;
+
+static bool runJob(RenderCluster cluster, renderState *state);
+
+// called on the coordinator as tiles arrive, only takes the lock to set a bit
+static void storeTile(const clusterTile *tile, int **scores, void *data);
+
+// the background thread, rewrites the checkpoint whenever tiles completed since the last one
+static void *checkpointLoop(void *data);
+
+// sync the scores, then atomically replace the checkpoint with this bitmap
+static bool writeCheckpoint(renderState *state, const unsigned char *bitmap);
+
+static bool isCompleted(const unsigned char *bitmap, int tile);
+
+// whether a checkpoint records the same render as a job
+static bool isSameJob(const checkpointJob *recorded, const checkpointJob *job);
+
+static void initState(renderState *state, RenderCluster cluster, const checkpointJob *job,
+                      const char *checkpointPath, int intervalSeconds);
+static void freeState(renderState *state);
+
+
+bool CheckpointRender_start(RenderCluster cluster, const checkpointJob *job,
+                            const char *checkpointPath, int intervalSeconds) {
+   scoreFileHeader header;
+   off_t outputSize = sizeof header + (off_t)sizeof (int32_t) * job->width * job->height;
+   renderState state;
+   bool isRendered = false;
+
+   initState(&state, cluster, job, checkpointPath, intervalSeconds);
+
+   state.outputFd = open(job->outputPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (state.outputFd >= 0) {
+      header.magic = SCORE_FILE_MAGIC;
+      header.width = job->width;
+      header.height = job->height;
+      header.maxIterations = job->maxIterations;
+
+      // write an empty checkpoint straight away so even an early crash can resume
+      if (FileIO_writeFully(state.outputFd, &header, sizeof header) &&
+          ftruncate(state.outputFd, outputSize) == 0 &&
+          writeCheckpoint(&state, state.completed)) {
+         isRendered = runJob(cluster, &state);
+      }
+      close(state.outputFd);
+   }
+
+   freeState(&state);
+   return isRendered;
+}
+
+bool CheckpointRender_resume(RenderCluster cluster, const checkpointJob *job,
+                             const char *checkpointPath, int intervalSeconds) {
+   checkpointHeader header;
+   scoreFileHeader scoreHeader;
+   renderState state;
+   bool isRendered = false;
+   bool isValid;
+
+   int fd = open(checkpointPath, O_RDONLY);
+   if (fd < 0) {
+      return false;
+   }
+
+   // another job's tiles would be silently mixed into this one's output
+   if (!FileIO_readFully(fd, &header, sizeof header) || header.magic != CHECKPOINT_MAGIC ||
+       !isSameJob(&header.job, job)) {
+      close(fd);
+      return false;
+   }
+
+   initState(&state, cluster, job, checkpointPath, intervalSeconds);
+
+   isValid = (header.tileCount == (uint32_t)state.tileCount) &&
+             FileIO_readFully(fd, state.completed, state.bitmapSize);
+   close(fd);
+
+   if (isValid) {
+      state.outputFd = open(job->outputPath, O_RDWR);
+      if (state.outputFd >= 0) {
+         if (FileIO_readFully(state.outputFd, &scoreHeader, sizeof scoreHeader) &&
+             scoreHeader.magic == SCORE_FILE_MAGIC &&
+             scoreHeader.width == job->width && scoreHeader.height == job->height &&
+             scoreHeader.maxIterations == job->maxIterations) {
+            isRendered = runJob(cluster, &state);
+         }
+         close(state.outputFd);
+      }
+   }
+
+   freeState(&state);
+   return isRendered;
+}
+
+
+// Static functions
+
+static bool runJob(RenderCluster cluster, renderState *state) {
+   pthread_t checkpointThread;
+   int tile;
+   int missingCount = 0;
+   int unrendered;
+   clusterTile *missing = malloc(sizeof (clusterTile) * state->tileCount);
+   assert(missing != NULL);
+
+   for (tile = 0; tile != state->tileCount; ++tile) {
+      if (!isCompleted(state->completed, tile)) {
+         missing[missingCount++] = state->tiles[tile];
+      }
+   }
+
+   if (pthread_create(&checkpointThread, NULL, checkpointLoop, state) != 0) {
+      free(missing);
+      return false;
+   }
+
+   RenderCluster_setMaxIterations(cluster, state->job->maxIterations);
+   unrendered = RenderCluster_renderTiles(cluster, missing, missingCount, storeTile, state);
+
+   pthread_mutex_lock(&state->lock);
+   state->isFinished = true;
+   pthread_cond_signal(&state->finished);
+   pthread_mutex_unlock(&state->lock);
+   pthread_join(checkpointThread, NULL);
+
+   free(missing);
+
+   // a tile the cluster gave up on is still missing, and the checkpoint stays
+   // for a resume to retry it
+   if (state->hasFailed || unrendered > 0) {
+      return false;
+   }
+
+   // every tile is on disk, there is nothing left to resume
+   if (fsync(state->outputFd) != 0) {
+      return false;
+   }
+   unlink(state->checkpointPath);
+
+   return true;
+}
+
+static void storeTile(const clusterTile *tile, int **scores, void *data) {
+   renderState *state = data;
+   int row;
+   off_t offset;
+   size_t rowSize = sizeof (int32_t) * tile->width;
+   bool isFailed;
+
+   for (row = 0; row != tile->height; ++row) {
+      offset = sizeof (scoreFileHeader) +
+               ((off_t)(tile->top + row) * state->job->width + tile->left) * (off_t)sizeof (int32_t);
+      if (pwrite(state->outputFd, scores[row], rowSize, offset) != (ssize_t)rowSize) {
+         // the output is unusable, rendering the rest would only waste the cluster
+         pthread_mutex_lock(&state->lock);
+         state->hasFailed = true;
+         pthread_mutex_unlock(&state->lock);
+         RenderCluster_cancel(state->cluster);
+         return;
+      }
+   }
+
+   pthread_mutex_lock(&state->lock);
+   state->completed[tile->id / 8] |= (unsigned char)(1 << (tile->id % 8));
+   state->isDirty = true;
+   isFailed = state->hasFailed;
+   pthread_mutex_unlock(&state->lock);
+
+   if (isFailed) {
+      // the checkpoint thread couldn't write, nothing more can be made durable
+      RenderCluster_cancel(state->cluster);
+   }
+}
+
+static void *checkpointLoop(void *data) {
+   renderState *state = data;
+   struct timespec deadline;
+   bool isWritten;
+
+   pthread_mutex_lock(&state->lock);
+   while (true) {
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += state->intervalSeconds;
+      while (!state->isFinished &&
+             pthread_cond_timedwait(&state->finished, &state->lock, &deadline) != ETIMEDOUT) {
+         // woken early or spuriously, keep waiting out the interval
+      }
+
+      if (state->isDirty && !state->isFinished) {
+         // copy under the lock, then do the slow I/O without it so tiles keep landing
+         memcpy(state->snapshot, state->completed, state->bitmapSize);
+         state->isDirty = false;
+         pthread_mutex_unlock(&state->lock);
+
+         isWritten = writeCheckpoint(state, state->snapshot);
+
+         pthread_mutex_lock(&state->lock);
+         if (!isWritten) {
+            state->hasFailed = true;
+         }
+      }
+
+      if (state->isFinished) {
+         break;
+      }
+   }
+   pthread_mutex_unlock(&state->lock);
+
+   return NULL;
+}
+
+static bool writeCheckpoint(renderState *state, const unsigned char *bitmap) {
+   checkpointHeader header;
+   char temporaryPath[CHECKPOINT_PATH_LENGTH + 8];
+   bool isWritten;
+   int fd;
+
+   // the bitmap must never run ahead of the scores it describes
+   if (fdatasync(state->outputFd) != 0) {
+      return false;
+   }
+
+   memset(&header, 0, sizeof header);
+   header.magic = CHECKPOINT_MAGIC;
+   header.tileCount = state->tileCount;
+   header.job = *state->job;
+
+   snprintf(temporaryPath, sizeof temporaryPath, "%s.tmp", state->checkpointPath);
+   fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0) {
+      return false;
+   }
+
+   isWritten = FileIO_writeFully(fd, &header, sizeof header) &&
+               FileIO_writeFully(fd, bitmap, state->bitmapSize) &&
+               fsync(fd) == 0;
+   isWritten = (close(fd) == 0) && isWritten;
+
+   // rename is atomic, a crash leaves either the old or the new checkpoint
+   return isWritten && rename(temporaryPath, state->checkpointPath) == 0;
+}
+
+static bool isCompleted(const unsigned char *bitmap, int tile) {
+   return (bitmap[tile / 8] & (1 << (tile % 8))) != 0;
+}
+
+static bool isSameJob(const checkpointJob *recorded, const checkpointJob *job) {
+   return recorded->center.x == job->center.x && recorded->center.y == job->center.y &&
+          recorded->zoom == job->zoom &&
+          recorded->width == job->width && recorded->height == job->height &&
+          recorded->tileSize == job->tileSize &&
+          recorded->maxIterations == job->maxIterations &&
+          strncmp(recorded->outputPath, job->outputPath, CHECKPOINT_PATH_LENGTH) == 0;
+}
+
+static void initState(renderState *state, RenderCluster cluster, const checkpointJob *job,
+                      const char *checkpointPath, int intervalSeconds) {
+   state->cluster = cluster;
+   state->job = job;
+   state->checkpointPath = checkpointPath;
+   state->outputFd = -1;
+   state->intervalSeconds = intervalSeconds;
+
+   state->tileCount = RenderCluster_splitViewport(job->center, job->zoom, job->width, job->height,
+                                                  job->tileSize, &state->tiles);
+
+   state->bitmapSize = (state->tileCount + 7) / 8;
+   state->completed = calloc(state->bitmapSize, 1);
+   state->snapshot = calloc(state->bitmapSize, 1);
+   assert(state->completed != NULL && state->snapshot != NULL);
+
+   pthread_mutex_init(&state->lock, NULL);
+   pthread_cond_init(&state->finished, NULL);
+   state->isDirty = false;
+   state->isFinished = false;
+   state->hasFailed = false;
+}
+
+static void freeState(renderState *state) {
+   pthread_cond_destroy(&state->finished);
+   pthread_mutex_destroy(&state->lock);
+   free(state->snapshot);
+   free(state->completed);
+   free(state->tiles);
+}
@@ -0,0 +1,53 @@
+#ifndef CHECKPOINT_RENDER_H
+#define CHECKPOINT_RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "RenderCluster.h"
+
+// Long renders that survive a crash or pre-emption.
+//
+// Scores go straight to a score file as tiles complete. A checkpoint file
+// records the job and a bitmap of completed tiles; it is rewritten in the
+// background (scores synced first, then the bitmap written and renamed
+// into place), so it never claims a tile whose scores are not on disk.
+//
+// score file | scoreFileHeader, then width * height int32 scores row by row
+
+#define SCORE_FILE_MAGIC 0x4353424d  // "MBSC"
+#define CHECKPOINT_MAGIC 0x5043424d  // "MBCP"
+
+#define CHECKPOINT_PATH_LENGTH 1024
+
+typedef struct {
+   uint32_t magic;
+   int32_t width;
+   int32_t height;
+   int32_t maxIterations;
+} scoreFileHeader;
+
+typedef struct {
+   mandelbrotCoord center;
+   int zoom;
+   int width;
+   int height;
+   int tileSize;
+   int maxIterations;
+   char outputPath[CHECKPOINT_PATH_LENGTH];
+} checkpointJob;
+
+// render a job from scratch, checkpointing at most every intervalSeconds
+// the checkpoint is removed once every tile is on disk
+// returns false, abandoning the render, as soon as the output or checkpoint can't be written,
+// or keeping the checkpoint if the cluster gave up on any tile
+bool CheckpointRender_start(RenderCluster cluster, const checkpointJob *job,
+                            const char *checkpointPath, int intervalSeconds);
+
+// continue a job from its checkpoint, rendering only the missing tiles
+// returns false if the checkpoint is missing or unreadable, records a different
+// job (view, size, tile size, maxIterations or output), or writing fails as for start
+bool CheckpointRender_resume(RenderCluster cluster, const checkpointJob *job,
+                             const char *checkpointPath, int intervalSeconds);
+
+#endif
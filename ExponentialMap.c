@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "ExponentialMap.h"
+
+#define TWO_PI 6.28318530717958647692528676655900576L
+
+struct exponentialMapData {
+   mandelbrotCoord center;
+   real minRadius;
+
+   int angleSamples;
+   int radiusSamples;
+
+   // natural log of the ratio between consecutive row radii
+   real logStep;
+
+   // radiusSamples rows of angleSamples scores, in one block
+   int **scores;
+
+   // only used for its kernel settings (max iterations)
+   MandelbrotSet kernel;
+};
+
+struct exponentialResamplerData {
+   ExponentialMap map;
+   int width;
+   int height;
+
+   // per pixel: strip row at resolution 1 (before the zoom offset), and strip column
+   float *rowBase;
+   float *column;
+};
+
+
+ExponentialMap createExponentialMap(mandelbrotCoord center, real minRadius, real maxRadius, int angleSamples) {
+   int row;
+
+   assert(minRadius > 0 && maxRadius > minRadius && angleSamples > 0);
+
+   ExponentialMap map = malloc(sizeof (struct exponentialMapData));
+   assert(map != NULL);
+
+   map->center = center;
+   map->minRadius = minRadius;
+   map->angleSamples = angleSamples;
+
+   // square samples: the radial step matches the arc between neighbouring angles
+   map->logStep = TWO_PI / angleSamples;
+   map->radiusSamples = (int)ceill(logl(maxRadius / minRadius) / map->logStep) + 1;
+
+   map->scores = malloc(sizeof (int *) * map->radiusSamples);
+   assert(map->scores != NULL);
+   map->scores[0] = malloc(sizeof (int) * map->radiusSamples * angleSamples);
+   assert(map->scores[0] != NULL);
+   for (row = 1; row != map->radiusSamples; ++row) {
+      map->scores[row] = map->scores[0] + (size_t)row * angleSamples;
+   }
+
+   map->kernel = createMandelbrotSet(1, 1);
+
+   return map;
+}
+
+void freeExponentialMap(ExponentialMap map) {
+   freeMandelbrotSet(map->kernel);
+   free(map->scores[0]);
+   free(map->scores);
+   free(map);
+}
+
+void ExponentialMap_setMaxIterations(ExponentialMap map, int maxIterations) {
+   MandelbrotSet_setMaxIterations(map->kernel, maxIterations);
+}
+
+void ExponentialMap_render(ExponentialMap map) {
+   int row, col;
+   real radius, angle;
+   mandelbrotCoord coord;
+
+   for (row = 0; row != map->radiusSamples; ++row) {
+      radius = map->minRadius * expl(map->logStep * row);
+      for (col = 0; col != map->angleSamples; ++col) {
+         angle = (TWO_PI * col) / map->angleSamples;
+         coord.x = map->center.x + radius * cosl(angle);
+         coord.y = map->center.y + radius * sinl(angle);
+         map->scores[row][col] = MandelbrotSet_scoreAt(map->kernel, coord);
+      }
+   }
+}
+
+int ExponentialMap_getRadiusSamples(ExponentialMap map) {
+   return map->radiusSamples;
+}
+
+int **ExponentialMap_getScores(ExponentialMap map) {
+   return map->scores;
+}
+
+
+ExponentialResampler createExponentialResampler(ExponentialMap map, int width, int height) {
+   int row, col;
+   size_t pixel;
+   double dx, dy, angle;
+
+   ExponentialResampler resampler = malloc(sizeof (struct exponentialResamplerData));
+   assert(resampler != NULL);
+
+   resampler->map = map;
+   resampler->width = width;
+   resampler->height = height;
+
+   resampler->rowBase = malloc(sizeof (float) * width * height);
+   resampler->column  = malloc(sizeof (float) * width * height);
+   assert(resampler->rowBase != NULL && resampler->column != NULL);
+
+   for (row = 0; row != height; ++row) {
+      // pixel centers relative to the frame center, y up as in the fractal plane
+      dy = (height / 2.0) - (row + 0.5);
+      for (col = 0; col != width; ++col) {
+         dx = (col + 0.5) - (width / 2.0);
+         pixel = (size_t)row * width + col;
+
+         angle = atan2(dy, dx);
+         if (angle < 0) {
+            angle += TWO_PI;
+         }
+
+         resampler->rowBase[pixel] = (float)(0.5 * log(dx*dx + dy*dy) / map->logStep);
+         resampler->column[pixel]  = (float)(angle / map->logStep);
+      }
+   }
+
+   return resampler;
+}
+
+void freeExponentialResampler(ExponentialResampler resampler) {
+   free(resampler->rowBase);
+   free(resampler->column);
+   free(resampler);
+}
+
+void ExponentialResampler_renderFrame(ExponentialResampler resampler, real resolution, int **frame) {
+   ExponentialMap map = resampler->map;
+   int row, col;
+   size_t pixel;
+   int lastRow = map->radiusSamples - 1;
+   int angles = map->angleSamples;
+
+   // moving between frames only shifts which strip rows the pixels land on
+   float offset = (float)(logl(resolution / map->minRadius) / map->logStep);
+
+   float rowPosition, columnPosition, rowFraction, columnFraction;
+   int stripRow, stripCol, nextRow, nextCol;
+   float top, bottom;
+
+   for (row = 0; row != resampler->height; ++row) {
+      for (col = 0; col != resampler->width; ++col) {
+         pixel = (size_t)row * resampler->width + col;
+
+         rowPosition = resampler->rowBase[pixel] + offset;
+         if (rowPosition < 0) {
+            rowPosition = 0;
+         } else if (rowPosition > lastRow) {
+            rowPosition = lastRow;
+         }
+         stripRow = (int)rowPosition;
+         rowFraction = rowPosition - stripRow;
+         nextRow = (stripRow == lastRow) ? lastRow : stripRow + 1;
+
+         columnPosition = resampler->column[pixel];
+         stripCol = (int)columnPosition;
+         columnFraction = columnPosition - stripCol;
+         stripCol = stripCol % angles;
+         nextCol = (stripCol + 1) % angles;
+
+         // bilinear, wrapping around the angle
+         top    = map->scores[stripRow][stripCol] +
+                  columnFraction * (map->scores[stripRow][nextCol] - map->scores[stripRow][stripCol]);
+         bottom = map->scores[nextRow][stripCol] +
+                  columnFraction * (map->scores[nextRow][nextCol] - map->scores[nextRow][stripCol]);
+
+         frame[row][col] = (int)(top + rowFraction * (bottom - top) + 0.5f);
+      }
+   }
+}
@@ -0,0 +1,41 @@
+#ifndef EXPONENTIAL_MAP_H
+#define EXPONENTIAL_MAP_H
+
+#include "MandelbrotSet.h"
+
+// A log-polar strip around a zoom center: columns step evenly through the angle,
+// rows step geometrically through the radius, so a whole zoom is rendered once
+// and every frame is resampled from it
+//
+// rows are spaced by the same factor as columns so samples are roughly square;
+// to match a width x height frame at its corners use about 4.5 * width angle samples
+
+typedef struct exponentialMapData *ExponentialMap;
+typedef struct exponentialResamplerData *ExponentialResampler;
+
+// covers radii [minRadius, maxRadius] in fractal coordinates
+ExponentialMap createExponentialMap(mandelbrotCoord center, real minRadius, real maxRadius, int angleSamples);
+
+void freeExponentialMap(ExponentialMap map);
+
+void ExponentialMap_setMaxIterations(ExponentialMap map, int maxIterations);
+
+// compute every sample of the strip
+void ExponentialMap_render(ExponentialMap map);
+
+int ExponentialMap_getRadiusSamples(ExponentialMap map);
+
+// returns a borrowed reference, indexed [radius row][angle column], row 0 innermost
+int **ExponentialMap_getScores(ExponentialMap map);
+
+// Cartesian frames centered on the map's center
+// the per-pixel polar geometry is computed once here, frames only add a zoom offset
+ExponentialResampler createExponentialResampler(ExponentialMap map, int width, int height);
+
+void freeExponentialResampler(ExponentialResampler resampler);
+
+// fill a width x height grid with the frame whose pixels are resolution apart
+// radii outside the strip are clamped to its first or last row
+void ExponentialResampler_renderFrame(ExponentialResampler resampler, real resolution, int **frame);
+
+#endif
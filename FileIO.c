@@ -0,0 +1,53 @@
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "FileIO.h"
+
+bool FileIO_readFully(int fd, void *buffer, size_t length) {
+   char *position = buffer;
+   ssize_t count;
+
+   while (length > 0) {
+      count = read(fd, position, length);
+      if (count < 0 && errno == EINTR) {
+         continue;
+      } else if (count <= 0) {
+         return false;
+      }
+      position += count;
+      length -= count;
+   }
+
+   return true;
+}
+
+bool FileIO_writeFully(int fd, const void *buffer, size_t length) {
+   const char *position = buffer;
+   bool isSocket = true;
+   ssize_t count;
+
+   while (length > 0) {
+      if (isSocket) {
+         count = send(fd, position, length, MSG_NOSIGNAL);
+         if (count < 0 && errno == ENOTSOCK) {
+            // a pipe or file, fall back to plain writes
+            isSocket = false;
+            continue;
+         }
+      } else {
+         count = write(fd, position, length);
+      }
+
+      if (count < 0 && errno == EINTR) {
+         continue;
+      } else if (count <= 0) {
+         return false;
+      }
+      position += count;
+      length -= count;
+   }
+
+   return true;
+}
@@ -0,0 +1,15 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// blocking helpers for descriptors that may return short counts (sockets, pipes)
+
+// returns false on error or if the peer closed before length bytes arrived
+bool FileIO_readFully(int fd, void *buffer, size_t length);
+
+// returns false on error, including a closed peer (which never raises SIGPIPE on sockets)
+bool FileIO_writeFully(int fd, const void *buffer, size_t length);
+
+#endif
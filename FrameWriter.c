@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "FrameWriter.h"
+#include "FileIO.h"
+
+#define Y4M_FRAME_MARKER "FRAME\n"
+#define NEUTRAL_CHROMA 128
+
+struct frameWriterData {
+   int fd;
+   int width;
+   int height;
+   frameFormat format;
+   bool hasWrittenHeader;
+   int framesPerSecond;
+
+   // one reused frame: marker, luma plane, then chroma planes for Y4M
+   unsigned char *frame;
+   unsigned char *luma;
+   size_t frameSize;
+};
+
+static bool writeHeader(FrameWriter writer);
+
+
+FrameWriter createFrameWriter(int fd, int width, int height, frameFormat format, int framesPerSecond) {
+   size_t markerSize = 0;
+   size_t lumaSize = (size_t)width * height;
+   size_t chromaSize = 0;
+
+   FrameWriter writer = malloc(sizeof (struct frameWriterData));
+   assert(writer != NULL);
+
+   writer->fd = fd;
+   writer->width = width;
+   writer->height = height;
+   writer->format = format;
+   writer->framesPerSecond = framesPerSecond;
+   writer->hasWrittenHeader = false;
+
+   if (format == FRAME_FORMAT_Y4M) {
+      markerSize = strlen(Y4M_FRAME_MARKER);
+      chromaSize = 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2);
+   }
+
+   writer->frameSize = markerSize + lumaSize + chromaSize;
+   writer->frame = malloc(writer->frameSize);
+   assert(writer->frame != NULL);
+
+   // the marker and chroma never change, only luma is rewritten per frame
+   memcpy(writer->frame, Y4M_FRAME_MARKER, markerSize);
+   writer->luma = writer->frame + markerSize;
+   memset(writer->luma + lumaSize, NEUTRAL_CHROMA, chromaSize);
+
+   return writer;
+}
+
+void freeFrameWriter(FrameWriter writer) {
+   free(writer->frame);
+   free(writer);
+}
+
+bool FrameWriter_writeScores(FrameWriter writer, int **scores, int maxIterations) {
+   int row, col;
+   int *scoreRow;
+   unsigned char *lumaRow;
+
+   if (!writer->hasWrittenHeader) {
+      if (!writeHeader(writer)) {
+         return false;
+      }
+      writer->hasWrittenHeader = true;
+   }
+
+   for (row = 0; row != writer->height; ++row) {
+      scoreRow = scores[row];
+      lumaRow = writer->luma + (size_t)row * writer->width;
+      for (col = 0; col != writer->width; ++col) {
+         lumaRow[col] = (unsigned char)((scoreRow[col] * 255) / maxIterations);
+      }
+   }
+
+   return FileIO_writeFully(writer->fd, writer->frame, writer->frameSize);
+}
+
+
+// Static functions
+
+static bool writeHeader(FrameWriter writer) {
+   char header[128];
+   int length;
+
+   if (writer->format != FRAME_FORMAT_Y4M) {
+      // raw frames have no stream header
+      return true;
+   }
+
+   length = snprintf(header, sizeof header, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n",
+                     writer->width, writer->height, writer->framesPerSecond);
+
+   return FileIO_writeFully(writer->fd, header, length);
+}
@@ -0,0 +1,27 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <stdbool.h>
+
+// Streams frames to a pipe or file descriptor as they are generated,
+// e.g. straight into `ffmpeg -i - out.mp4` rather than via PGM files on disk
+
+typedef enum {
+   // YUV4MPEG2 stream, grey frames with constant 4:2:0 chroma
+   FRAME_FORMAT_Y4M,
+   // 8 bit luma only, one width x height plane per frame, no headers
+   FRAME_FORMAT_RAW
+} frameFormat;
+
+typedef struct frameWriterData *FrameWriter;
+
+// the descriptor is borrowed, it is not closed by freeFrameWriter
+FrameWriter createFrameWriter(int fd, int width, int height, frameFormat format, int framesPerSecond);
+
+void freeFrameWriter(FrameWriter writer);
+
+// scale scores from [0, maxIterations] to luma and write one frame
+// returns false if the descriptor stopped accepting data (e.g. the encoder exited)
+bool FrameWriter_writeScores(FrameWriter writer, int **scores, int maxIterations);
+
+#endif
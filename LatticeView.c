@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "LatticeView.h"
+#include "MandelbrotAsync.h"
+#include "TileArchive.h"
+
+struct latticeViewData {
+   int width;
+   int height;
+   TileCache cache;
+   MandelbrotPool pool;
+
+   int zoom;
+   mandelbrotCoord center;
+   // lattice pixel at the view's top-left corner, counted from the plane's corner
+   long long left;
+   long long top;
+
+   int **scores;
+   int renderCount;
+
+   // renders tiles missing from the cache
+   MandelbrotSet fractal;
+   // decodes tiles found in the cache
+   int **tile;
+   unsigned char *payload;
+   size_t capacity;
+};
+
+// the scores of one tile, from the cache or freshly rendered (and cached)
+static int **loadTile(LatticeView view, long long tileX, long long tileY);
+
+static long long floorDivide(long long value, long long divisor);
+
+static int **createGrid(int width, int height);
+static void freeGrid(int **grid);
+
+
+LatticeView createLatticeView(int width, int height, TileCache cache, MandelbrotPool pool, int maxIterations) {
+   mandelbrotCoord origin = { 0, 0 };
+
+   LatticeView view = malloc(sizeof (struct latticeViewData));
+   assert(view != NULL);
+
+   view->width = width;
+   view->height = height;
+   view->cache = cache;
+   view->pool = pool;
+
+   view->scores = createGrid(width, height);
+   view->renderCount = 0;
+
+   view->fractal = createMandelbrotSet(TILE_SIZE, TILE_SIZE);
+   MandelbrotSet_setMaxIterations(view->fractal, maxIterations);
+   view->tile = createGrid(TILE_SIZE, TILE_SIZE);
+   view->payload = NULL;
+   view->capacity = 0;
+
+   LatticeView_setPosition(view, origin, TILE_ZOOM_OFFSET);
+
+   return view;
+}
+
+void freeLatticeView(LatticeView view) {
+   freeMandelbrotSet(view->fractal);
+   freeGrid(view->tile);
+   freeGrid(view->scores);
+   free(view->payload);
+   free(view);
+}
+
+bool LatticeView_setPosition(LatticeView view, mandelbrotCoord center, int zoom) {
+   real resolution;
+
+   if (zoom < TILE_ZOOM_OFFSET || zoom > TILE_ZOOM_OFFSET + LATTICE_MAX_LEVEL) {
+      return false;
+   }
+
+   view->zoom = zoom;
+   view->center = TilePyramid_snapCenter(center, zoom, view->width, view->height);
+
+   // snapping made these whole numbers
+   resolution = 1.0/((real)((unsigned long long)1 << zoom));
+   view->left = llroundl((view->center.x - (view->width  * resolution)/2.0 - TILE_PLANE_LEFT) / resolution);
+   view->top  = llroundl((TILE_PLANE_TOP - (view->center.y + (view->height * resolution)/2.0)) / resolution);
+
+   return true;
+}
+
+mandelbrotCoord LatticeView_getCenter(LatticeView view) {
+   return view->center;
+}
+
+void LatticeView_generate(LatticeView view) {
+   long long tileX, tileY;
+   long long firstX, lastX, firstY, lastY;
+   int **tile;
+   int row, startCol, endCol, startRow, endRow;
+
+   firstX = floorDivide(view->left, TILE_SIZE);
+   lastX  = floorDivide(view->left + view->width - 1, TILE_SIZE);
+   firstY = floorDivide(view->top, TILE_SIZE);
+   lastY  = floorDivide(view->top + view->height - 1, TILE_SIZE);
+
+   view->renderCount = 0;
+
+   for (tileY = firstY; tileY <= lastY; ++tileY) {
+      for (tileX = firstX; tileX <= lastX; ++tileX) {
+         tile = loadTile(view, tileX, tileY);
+
+         // the part of the tile inside the view, in tile pixels
+         startCol = (tileX == firstX) ? (int)(view->left - firstX * TILE_SIZE) : 0;
+         endCol   = (tileX == lastX)  ? (int)(view->left + view->width - lastX * TILE_SIZE) : TILE_SIZE;
+         startRow = (tileY == firstY) ? (int)(view->top - firstY * TILE_SIZE) : 0;
+         endRow   = (tileY == lastY)  ? (int)(view->top + view->height - lastY * TILE_SIZE) : TILE_SIZE;
+
+         for (row = startRow; row != endRow; ++row) {
+            memcpy(&view->scores[tileY * TILE_SIZE + row - view->top][tileX * TILE_SIZE + startCol - view->left],
+                   &tile[row][startCol], sizeof (int) * (endCol - startCol));
+         }
+      }
+   }
+}
+
+int **LatticeView_getScores(LatticeView view) {
+   return view->scores;
+}
+
+int LatticeView_getRenderCount(LatticeView view) {
+   return view->renderCount;
+}
+
+
+// Static functions
+
+static int **loadTile(LatticeView view, long long tileX, long long tileY) {
+   tileKey key;
+   mandelbrotCoord center;
+   size_t length;
+   int level = view->zoom - TILE_ZOOM_OFFSET;
+   long long tilesAcross = 1LL << level;
+   real tileWidth = TILE_PLANE_SIZE / (real)tilesAcross;
+
+   // tiles off the plane have no key, but escape at once so are cheap to render every time
+   bool hasKey = tileX >= 0 && tileY >= 0 && tileX < tilesAcross && tileY < tilesAcross;
+
+   key.z = level;
+   key.x = (unsigned int)tileX;
+   key.y = (unsigned int)tileY;
+
+   if (hasKey) {
+      if (TileCache_get(view->cache, key, &view->payload, &view->capacity, &length) &&
+          TileArchive_decodeScores(view->payload, length, view->tile, TILE_SIZE)) {
+         return view->tile;
+      }
+      center = TilePyramid_tileCenter(key);
+   } else {
+      center.x = TILE_PLANE_LEFT + tileWidth * (tileX + 0.5);
+      center.y = TILE_PLANE_TOP  - tileWidth * (tileY + 0.5);
+   }
+
+   // rendered exactly as the tile server and prefetcher render, so the cache stays consistent
+   MandelbrotSet_setPosition(view->fractal, center, view->zoom);
+   freeMandelbrotRender(MandelbrotSet_generateAsync(view->fractal, view->pool, MANDELBROT_FAST_GENERATE));
+   view->renderCount++;
+
+   if (hasKey) {
+      length = TileArchive_encodeScores(MandelbrotSet_getScores(view->fractal), TILE_SIZE,
+                                        &view->payload, &view->capacity);
+      TileCache_put(view->cache, key, view->payload, length);
+   }
+
+   return MandelbrotSet_getScores(view->fractal);
+}
+
+static long long floorDivide(long long value, long long divisor) {
+   long long quotient = value / divisor;
+
+   if ((value % divisor != 0) && ((value < 0) != (divisor < 0))) {
+      quotient--;
+   }
+
+   return quotient;
+}
+
+static int **createGrid(int width, int height) {
+   int row;
+
+   int **grid = malloc(sizeof (int *) * height);
+   assert(grid != NULL);
+   grid[0] = malloc(sizeof (int) * width * height);
+   assert(grid[0] != NULL);
+   for (row = 1; row != height; ++row) {
+      grid[row] = grid[0] + (size_t)row * width;
+   }
+
+   return grid;
+}
+
+static void freeGrid(int **grid) {
+   free(grid[0]);
+   free(grid);
+}
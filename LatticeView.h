@@ -0,0 +1,51 @@
+#ifndef LATTICE_VIEW_H
+#define LATTICE_VIEW_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+#include "MandelbrotPool.h"
+#include "TileCache.h"
+
+// Viewports assembled from pyramid tiles, so overlapping views share work.
+//
+// A freely positioned view almost never shares pixel centers with another, so
+// nothing it computes can be reused. A lattice view snaps its position to the
+// pyramid's pixel lattice for its zoom (TilePyramid_snapCenter) and fills
+// itself from the fixed tiles covering it, taking each from the cache or
+// rendering and caching it. Every tile is rendered the same way whichever view
+// asked first, so overlapping views agree bit for bit, and agree with a tile
+// server sharing the cache.
+//
+// Tiles are rendered with fastGenerate, so the process must keep the built-in
+// profile (see TilePyramid_renderTile), and the cache must only ever hold tiles
+// of one maxIterations.
+
+// deepest pyramid level a tileKey can address
+#define LATTICE_MAX_LEVEL 31
+
+typedef struct latticeViewData *LatticeView;
+
+// borrows the cache and pool, which must outlive the view
+LatticeView createLatticeView(int width, int height, TileCache cache, MandelbrotPool pool, int maxIterations);
+
+void freeLatticeView(LatticeView view);
+
+// move to the lattice position nearest center, as MandelbrotSet_setPosition
+// returns false, changing nothing, unless zoom is within
+// [TILE_ZOOM_OFFSET, TILE_ZOOM_OFFSET + LATTICE_MAX_LEVEL]
+bool LatticeView_setPosition(LatticeView view, mandelbrotCoord center, int zoom);
+
+// the snapped center actually shown
+mandelbrotCoord LatticeView_getCenter(LatticeView view);
+
+void LatticeView_generate(LatticeView view);
+
+// returns a borrowed reference (freed when view is freed)
+// rows are stored back to back, so scores[0] addresses all width * height scores
+int **LatticeView_getScores(LatticeView view);
+
+// tiles the last generate had to render rather than take from the cache
+int LatticeView_getRenderCount(LatticeView view);
+
+#endif
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "MandelbrotAnimation.h"
+
+// reprojected scores are never re-checked, so render a frame from scratch
+// this often to stop errors drifting along the path
+#define ANIMATION_REFRESH_INTERVAL 30
+
+struct mandelbrotAnimationData {
+   int width;
+   int height;
+
+   animationKeyframe *keyframes;
+   int keyframeCount;
+
+   // frames alternate between these so the previous one is always available
+   MandelbrotSet frames[2];
+   int current;
+   int framesSinceRefresh;
+   bool hasPrevious;
+
+   int computedPixels;
+};
+
+// interpolate the camera between the keyframes either side of a time
+static void viewAtTime(MandelbrotAnimation animation, real time, mandelbrotCoord *center, real *resolution);
+
+
+MandelbrotAnimation createMandelbrotAnimation(int width, int height,
+                                              const animationKeyframe *keyframes, int keyframeCount) {
+   assert(keyframeCount > 0);
+
+   MandelbrotAnimation animation = malloc(sizeof (struct mandelbrotAnimationData));
+   assert(animation != NULL);
+
+   animation->keyframes = malloc(sizeof (animationKeyframe) * keyframeCount);
+   assert(animation->keyframes != NULL);
+   memcpy(animation->keyframes, keyframes, sizeof (animationKeyframe) * keyframeCount);
+   animation->keyframeCount = keyframeCount;
+
+   animation->width = width;
+   animation->height = height;
+
+   animation->frames[0] = createMandelbrotSet(width, height);
+   animation->frames[1] = createMandelbrotSet(width, height);
+   animation->current = 0;
+   animation->framesSinceRefresh = 0;
+   animation->hasPrevious = false;
+
+   animation->computedPixels = 0;
+
+   return animation;
+}
+
+void freeMandelbrotAnimation(MandelbrotAnimation animation) {
+   freeMandelbrotSet(animation->frames[0]);
+   freeMandelbrotSet(animation->frames[1]);
+   free(animation->keyframes);
+   free(animation);
+}
+
+void MandelbrotAnimation_setMaxIterations(MandelbrotAnimation animation, int maxIterations) {
+   MandelbrotSet_setMaxIterations(animation->frames[0], maxIterations);
+   MandelbrotSet_setMaxIterations(animation->frames[1], maxIterations);
+   animation->hasPrevious = false;
+}
+
+int **MandelbrotAnimation_renderFrame(MandelbrotAnimation animation, real time) {
+   mandelbrotCoord center;
+   real resolution;
+
+   MandelbrotSet previous = animation->frames[animation->current];
+   MandelbrotSet frame = animation->frames[1 - animation->current];
+
+   viewAtTime(animation, time, &center, &resolution);
+   MandelbrotSet_setView(frame, center, resolution);
+
+   if (animation->hasPrevious && animation->framesSinceRefresh < ANIMATION_REFRESH_INTERVAL) {
+      animation->computedPixels = MandelbrotSet_reproject(frame, previous);
+      animation->framesSinceRefresh++;
+   } else {
+      MandelbrotSet_fastGenerate(frame);
+      animation->computedPixels = animation->width * animation->height;
+      animation->framesSinceRefresh = 0;
+   }
+
+   animation->current = 1 - animation->current;
+   animation->hasPrevious = true;
+
+   return MandelbrotSet_getScores(frame);
+}
+
+int MandelbrotAnimation_getComputedPixels(MandelbrotAnimation animation) {
+   return animation->computedPixels;
+}
+
+
+// Static functions
+
+static void viewAtTime(MandelbrotAnimation animation, real time, mandelbrotCoord *center, real *resolution) {
+   const animationKeyframe *keyframes = animation->keyframes;
+   int last = animation->keyframeCount - 1;
+   int next = 0;
+   real t;
+
+   while (next <= last && keyframes[next].time <= time) {
+      next++;
+   }
+
+   if (next == 0 || next > last) {
+      // before the first or after the last keyframe
+      next = (next == 0) ? 0 : last;
+      *center = keyframes[next].center;
+      *resolution = keyframes[next].resolution;
+   } else {
+      const animationKeyframe *from = &keyframes[next - 1];
+      const animationKeyframe *to = &keyframes[next];
+
+      t = (time - from->time) / (to->time - from->time);
+
+      // zoom geometrically so the apparent speed is constant
+      *resolution = from->resolution * powl(to->resolution / from->resolution, t);
+
+      center->x = from->center.x + (to->center.x - from->center.x) * t;
+      center->y = from->center.y + (to->center.y - from->center.y) * t;
+   }
+}
@@ -0,0 +1,32 @@
+#ifndef MANDELBROT_ANIMATION_H
+#define MANDELBROT_ANIMATION_H
+
+#include "MandelbrotSet.h"
+
+// a point on the camera path
+typedef struct {
+   real time;
+   mandelbrotCoord center;
+   // distance between pixel centers, as passed to MandelbrotSet_setView
+   real resolution;
+} animationKeyframe;
+
+typedef struct mandelbrotAnimationData *MandelbrotAnimation;
+
+// keyframes must be sorted by time, they are copied
+MandelbrotAnimation createMandelbrotAnimation(int width, int height,
+                                              const animationKeyframe *keyframes, int keyframeCount);
+
+void freeMandelbrotAnimation(MandelbrotAnimation animation);
+
+void MandelbrotAnimation_setMaxIterations(MandelbrotAnimation animation, int maxIterations);
+
+// render the frame at a time along the path, reusing the previously rendered frame
+// times before the first or after the last keyframe hold that keyframe's view
+// returns a borrowed reference, valid until the next call
+int **MandelbrotAnimation_renderFrame(MandelbrotAnimation animation, real time);
+
+// number of pixels computed (rather than reprojected) for the last frame
+int MandelbrotAnimation_getComputedPixels(MandelbrotAnimation animation);
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "MandelbrotAsync.h"
+
+struct mandelbrotRenderData {
+   pthread_mutex_t lock;
+   pthread_cond_t done;
+   bool isDone;
+};
+
+typedef struct {
+   MandelbrotSet fractal;
+   mandelbrotStrategy strategy;
+
+   // exactly one of these is set
+   MandelbrotRender render;
+   mandelbrotRenderCallback callback;
+   void *data;
+} asyncJob;
+
+static void runJob(void *data);
+static void generate(MandelbrotSet fractal, mandelbrotStrategy strategy);
+
+
+MandelbrotRender MandelbrotSet_generateAsync(MandelbrotSet fractal, MandelbrotPool pool,
+                                             mandelbrotStrategy strategy) {
+   MandelbrotRender render = malloc(sizeof (struct mandelbrotRenderData));
+   assert(render != NULL);
+   asyncJob *job = malloc(sizeof (asyncJob));
+   assert(job != NULL);
+
+   pthread_mutex_init(&render->lock, NULL);
+   pthread_cond_init(&render->done, NULL);
+   render->isDone = false;
+
+   job->fractal = fractal;
+   job->strategy = strategy;
+   job->render = render;
+   job->callback = NULL;
+   job->data = NULL;
+
+   MandelbrotPool_submit(pool, runJob, job);
+
+   return render;
+}
+
+bool MandelbrotRender_isDone(MandelbrotRender render) {
+   bool isDone;
+
+   pthread_mutex_lock(&render->lock);
+   isDone = render->isDone;
+   pthread_mutex_unlock(&render->lock);
+
+   return isDone;
+}
+
+void MandelbrotRender_wait(MandelbrotRender render) {
+   pthread_mutex_lock(&render->lock);
+   while (!render->isDone) {
+      pthread_cond_wait(&render->done, &render->lock);
+   }
+   pthread_mutex_unlock(&render->lock);
+}
+
+void freeMandelbrotRender(MandelbrotRender render) {
+   MandelbrotRender_wait(render);
+
+   pthread_cond_destroy(&render->done);
+   pthread_mutex_destroy(&render->lock);
+   free(render);
+}
+
+void MandelbrotSet_generateWithCallback(MandelbrotSet fractal, MandelbrotPool pool,
+                                        mandelbrotStrategy strategy,
+                                        mandelbrotRenderCallback callback, void *data) {
+   asyncJob *job = malloc(sizeof (asyncJob));
+   assert(job != NULL);
+
+   job->fractal = fractal;
+   job->strategy = strategy;
+   job->render = NULL;
+   job->callback = callback;
+   job->data = data;
+
+   MandelbrotPool_submit(pool, runJob, job);
+}
+
+
+// Static functions
+
+static void runJob(void *data) {
+   asyncJob *job = data;
+
+   generate(job->fractal, job->strategy);
+
+   if (job->render != NULL) {
+      pthread_mutex_lock(&job->render->lock);
+      job->render->isDone = true;
+      pthread_cond_broadcast(&job->render->done);
+      pthread_mutex_unlock(&job->render->lock);
+   } else {
+      job->callback(job->fractal, job->data);
+   }
+
+   free(job);
+}
+
+static void generate(MandelbrotSet fractal, mandelbrotStrategy strategy) {
+   if (strategy == MANDELBROT_GENERATE) {
+      MandelbrotSet_generate(fractal);
+   } else {
+      MandelbrotSet_fastGenerate(fractal);
+   }
+}
@@ -0,0 +1,47 @@
+#ifndef MANDELBROT_ASYNC_H
+#define MANDELBROT_ASYNC_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+#include "MandelbrotPool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Non-blocking generation on a pool, for hosts built around an event loop.
+// The fractal must not be touched (other than by MandelbrotRender calls)
+// until the render completes.
+
+typedef enum {
+   MANDELBROT_GENERATE,
+   MANDELBROT_FAST_GENERATE
+} mandelbrotStrategy;
+
+typedef struct mandelbrotRenderData *MandelbrotRender;
+
+// called on the pool thread that finished the render
+typedef void (*mandelbrotRenderCallback)(MandelbrotSet fractal, void *data);
+
+// future form: returns a handle to poll or wait on, free it with freeMandelbrotRender
+MandelbrotRender MandelbrotSet_generateAsync(MandelbrotSet fractal, MandelbrotPool pool,
+                                             mandelbrotStrategy strategy);
+
+bool MandelbrotRender_isDone(MandelbrotRender render);
+
+void MandelbrotRender_wait(MandelbrotRender render);
+
+// waits for the render if it is still running
+void freeMandelbrotRender(MandelbrotRender render);
+
+// callback form: no handle, the callback is the completion signal
+void MandelbrotSet_generateWithCallback(MandelbrotSet fractal, MandelbrotPool pool,
+                                        mandelbrotStrategy strategy,
+                                        mandelbrotRenderCallback callback, void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef MANDELBROT_ASYNC_HPP
+#define MANDELBROT_ASYNC_HPP
+
+// C++20 coroutine adapter for MandelbrotAsync.h
+//
+//    int **scores = co_await mandelbrot::generate(fractal);
+//
+// the coroutine resumes on the pool thread that finished the render,
+// hop back onto your own loop afterwards if it is not thread safe
+
+#include <coroutine>
+
+#include "MandelbrotAsync.h"
+
+namespace mandelbrot {
+
+class GenerateAwaitable {
+public:
+   GenerateAwaitable(MandelbrotSet fractal, MandelbrotPool pool, mandelbrotStrategy strategy)
+      : fractal(fractal), pool(pool), strategy(strategy) {}
+
+   bool await_ready() const noexcept {
+      return false;
+   }
+
+   void await_suspend(std::coroutine_handle<> waiting) {
+      MandelbrotSet_generateWithCallback(fractal, pool, strategy, resume, waiting.address());
+   }
+
+   int **await_resume() const {
+      return MandelbrotSet_getScores(fractal);
+   }
+
+private:
+   static void resume(MandelbrotSet, void *waiting) {
+      std::coroutine_handle<>::from_address(waiting).resume();
+   }
+
+   MandelbrotSet fractal;
+   MandelbrotPool pool;
+   mandelbrotStrategy strategy;
+};
+
+inline GenerateAwaitable generate(MandelbrotSet fractal,
+                                  mandelbrotStrategy strategy = MANDELBROT_FAST_GENERATE,
+                                  MandelbrotPool pool = MandelbrotPool_getDefault()) {
+   return GenerateAwaitable(fractal, pool, strategy);
+}
+
+}
+
+#endif
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "MandelbrotPool.h"
+#include "Trace.h"
+
+typedef struct queuedTask {
+   poolTask task;
+   void *data;
+   struct queuedTask *next;
+} queuedTask;
+
+struct mandelbrotPoolData {
+   pthread_t *threads;
+   int threadCount;
+
+   // guards both queues and isStopping
+   pthread_mutex_t lock;
+   pthread_cond_t hasWork;
+   queuedTask *head;
+   queuedTask *tail;
+   queuedTask *backgroundHead;
+   queuedTask *backgroundTail;
+   bool isStopping;
+};
+
+static MandelbrotPool defaultPool = NULL;
+static pthread_once_t defaultPoolOnce = PTHREAD_ONCE_INIT;
+
+static void *workerLoop(void *data);
+static void enqueue(MandelbrotPool pool, queuedTask **head, queuedTask **tail, poolTask task, void *data);
+
+// take the next task, ordinary ones first, or NULL if both queues are empty
+static queuedTask *dequeue(MandelbrotPool pool);
+static void createDefaultPool(void);
+
+
+MandelbrotPool createMandelbrotPool(int threadCount) {
+   int thread;
+
+   if (threadCount <= 0) {
+      threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      if (threadCount <= 0) {
+         threadCount = 1;
+      }
+   }
+
+   MandelbrotPool pool = malloc(sizeof (struct mandelbrotPoolData));
+   assert(pool != NULL);
+
+   pool->threadCount = threadCount;
+   pool->head = NULL;
+   pool->tail = NULL;
+   pool->backgroundHead = NULL;
+   pool->backgroundTail = NULL;
+   pool->isStopping = false;
+   pthread_mutex_init(&pool->lock, NULL);
+   pthread_cond_init(&pool->hasWork, NULL);
+
+   pool->threads = malloc(sizeof (pthread_t) * threadCount);
+   assert(pool->threads != NULL);
+   for (thread = 0; thread != threadCount; ++thread) {
+      if (pthread_create(&pool->threads[thread], NULL, workerLoop, pool) != 0) {
+         perror("pthread_create");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   return pool;
+}
+
+void freeMandelbrotPool(MandelbrotPool pool) {
+   int thread;
+
+   pthread_mutex_lock(&pool->lock);
+   pool->isStopping = true;
+   pthread_cond_broadcast(&pool->hasWork);
+   pthread_mutex_unlock(&pool->lock);
+
+   for (thread = 0; thread != pool->threadCount; ++thread) {
+      pthread_join(pool->threads[thread], NULL);
+   }
+
+   pthread_cond_destroy(&pool->hasWork);
+   pthread_mutex_destroy(&pool->lock);
+   free(pool->threads);
+   free(pool);
+}
+
+void MandelbrotPool_submit(MandelbrotPool pool, poolTask task, void *data) {
+   enqueue(pool, &pool->head, &pool->tail, task, data);
+}
+
+void MandelbrotPool_submitBackground(MandelbrotPool pool, poolTask task, void *data) {
+   enqueue(pool, &pool->backgroundHead, &pool->backgroundTail, task, data);
+}
+
+bool MandelbrotPool_hasWaitingWork(MandelbrotPool pool) {
+   bool hasWaitingWork;
+
+   pthread_mutex_lock(&pool->lock);
+   hasWaitingWork = (pool->head != NULL);
+   pthread_mutex_unlock(&pool->lock);
+
+   return hasWaitingWork;
+}
+
+int MandelbrotPool_getThreadCount(MandelbrotPool pool) {
+   return pool->threadCount;
+}
+
+MandelbrotPool MandelbrotPool_getDefault(void) {
+   pthread_once(&defaultPoolOnce, createDefaultPool);
+   return defaultPool;
+}
+
+
+// Static functions
+
+static void *workerLoop(void *data) {
+   MandelbrotPool pool = data;
+   queuedTask *queued;
+   uint64_t start;
+
+   pthread_mutex_lock(&pool->lock);
+   while (true) {
+      // time spent waiting for work shows up as a stall on this thread's timeline
+      start = (pool->head == NULL && pool->backgroundHead == NULL && !pool->isStopping &&
+               Trace_isEnabled()) ? Trace_now() : 0;
+      while (pool->head == NULL && pool->backgroundHead == NULL && !pool->isStopping) {
+         pthread_cond_wait(&pool->hasWork, &pool->lock);
+      }
+      if (start != 0) {
+         Trace_record("idle", "pool", start, TRACE_NO_VALUE, TRACE_NO_VALUE);
+      }
+
+      queued = dequeue(pool);
+      if (queued == NULL) {
+         // stopping, and the queues have drained
+         break;
+      }
+
+      pthread_mutex_unlock(&pool->lock);
+      start = Trace_isEnabled() ? Trace_now() : 0;
+      queued->task(queued->data);
+      if (start != 0) {
+         Trace_record("task", "pool", start, TRACE_NO_VALUE, TRACE_NO_VALUE);
+      }
+      free(queued);
+      pthread_mutex_lock(&pool->lock);
+   }
+   pthread_mutex_unlock(&pool->lock);
+
+   return NULL;
+}
+
+static void enqueue(MandelbrotPool pool, queuedTask **head, queuedTask **tail, poolTask task, void *data) {
+   queuedTask *queued = malloc(sizeof (queuedTask));
+   assert(queued != NULL);
+
+   queued->task = task;
+   queued->data = data;
+   queued->next = NULL;
+
+   pthread_mutex_lock(&pool->lock);
+   if (*tail == NULL) {
+      *head = queued;
+   } else {
+      (*tail)->next = queued;
+   }
+   *tail = queued;
+   pthread_cond_signal(&pool->hasWork);
+   pthread_mutex_unlock(&pool->lock);
+}
+
+static queuedTask *dequeue(MandelbrotPool pool) {
+   queuedTask **head = (pool->head != NULL) ? &pool->head : &pool->backgroundHead;
+   queuedTask **tail = (pool->head != NULL) ? &pool->tail : &pool->backgroundTail;
+   queuedTask *queued = *head;
+
+   if (queued != NULL) {
+      *head = queued->next;
+      if (*head == NULL) {
+         *tail = NULL;
+      }
+   }
+
+   return queued;
+}
+
+static void createDefaultPool(void) {
+   defaultPool = createMandelbrotPool(0);
+}
@@ -0,0 +1,43 @@
+#ifndef MANDELBROT_POOL_H
+#define MANDELBROT_POOL_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A fixed set of worker threads running queued tasks in submission order.
+// Background tasks (speculative work such as prefetching) only start when no
+// ordinary task is waiting.
+
+typedef struct mandelbrotPoolData *MandelbrotPool;
+
+typedef void (*poolTask)(void *data);
+
+// threadCount 0 means one thread per online CPU
+MandelbrotPool createMandelbrotPool(int threadCount);
+
+// runs every queued task, then joins the threads
+void freeMandelbrotPool(MandelbrotPool pool);
+
+// queue a task, it runs on some pool thread (never the caller's)
+void MandelbrotPool_submit(MandelbrotPool pool, poolTask task, void *data);
+
+// queue a task behind every ordinary task, present and future
+void MandelbrotPool_submitBackground(MandelbrotPool pool, poolTask task, void *data);
+
+// true while ordinary tasks are queued; a long background task checks this
+// between slices and, if set, resubmits its remainder to yield its thread
+bool MandelbrotPool_hasWaitingWork(MandelbrotPool pool);
+
+int MandelbrotPool_getThreadCount(MandelbrotPool pool);
+
+// a process-wide pool created on first use and never freed
+MandelbrotPool MandelbrotPool_getDefault(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
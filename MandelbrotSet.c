@@ -2,24 +2,83 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
 
 #include "MandelbrotSet.h"
+#include "Trace.h"
 
 #define ESCAPE_RADIUS_SQ 4
 
+// a previous score is only reused if this many pixels either side agree with it
+#define REPROJECT_RADIUS 1
+
+// built-in profile, used unless a machine profile is loaded
+#define DEFAULT_TILE_WIDTH 64
+#define DEFAULT_MINIMUM_BLOCK 3
+
+#define MAX_TILE_WIDTH 4096
+#define PROFILE_LINE 256
+#define PROFILE_ENVIRONMENT "MANDELBROT_PROFILE"
+
+// tile flag for a tile never generated at any position
+#define NO_EPOCH 0
+
+// initial room on the block stack, it grows as needed
+#define PENDING_BLOCKS 64
+
+typedef struct {
+   int startX;
+   int startY;
+   int width;
+   int height;
+} pixelBlock;
+
 struct mandelbrotSetData {
    int width;
    int height;
-   mandelbrotCoord center;
-   
-   real resolution;
-   real top;
-   real left;
+
+   mandelbrotTransform transform;
+
+   // a pixel's center split into a part per column (including the origin) and a part
+   // per row, tabulated once per view so generating a pixel takes two additions
+   mandelbrotCoord *columnOffsets;
+   mandelbrotCoord *rowOffsets;
 
    int **pixelScores;
    int maxIterations;
 
    bool isGenerated;
+
+   // a seqlock over the scores: bumped before any score is rewritten (a new view, new
+   // settings, or another generate), and a tile is complete once its flag holds the
+   // current epoch. Flags are stored with release and loaded with acquire, so a reader
+   // that sees a tile's flag also sees that tile's scores; a reader rechecks the epoch
+   // after copying, so a copy that overlapped a rewrite is discarded
+   atomic_uint epoch;
+   atomic_uint *tileEpochs;
+   int tileWidth;
+   int tilesAcross;
+   int tilesDown;
+
+   // fastGenerate's stopping case, from the profile
+   int minimumBlock;
+
+   // escape-time evaluations so far, for tracing how much work each tile needed
+   long computedPixels;
+
+   // blocks of the current tile still to generate, taken last in first out
+   // so the traversal order matches plain recursion
+   pixelBlock *pending;
+   int pendingCount;
+   int pendingCapacity;
+
+   // time-sliced generation: the next tile to finish, and the view it was begun for
+   int stepTile;
+   bool isStepFast;
+   unsigned int stepEpoch;
 };
 
 // generate a rectangular section of the mandelbrot set pixel by pixel
@@ -28,6 +87,21 @@ static void generateRectangle(MandelbrotSet fractal, int startX, int startY, int
 // generate a rectangular section of the mandelbrot set by filling in chunks expected to be the same color
 static void generateDivideAndConquer(MandelbrotSet fractal, int startX, int startY, int width, int height);
 
+// one Mariani/Silver step: trace the block's border, then fill it or push its quadrants
+static void divideBlock(MandelbrotSet fractal, pixelBlock block);
+static void pushBlock(MandelbrotSet fractal, int startX, int startY, int width, int height);
+
+// push the work of one tile for the step API, the whole tile or (exact) its rows
+static void queueTile(MandelbrotSet fractal, int tile);
+static void getTileBounds(MandelbrotSet fractal, int tile, pixelBlock *bounds);
+
+// generate tile by tile, publishing each to concurrent readers as it completes
+static void generateTiles(MandelbrotSet fractal, bool isFast);
+static void publishTile(MandelbrotSet fractal, int tile);
+
+// the writer's half of the seqlock, called before rewriting any score
+static void invalidateTiles(MandelbrotSet fractal);
+
 static void allocatePixelScores(MandelbrotSet fractal);
 static void freePixelScores(MandelbrotSet fractal);
 
@@ -38,9 +112,22 @@ static inline int  escapeScore(MandelbrotSet fractal, mandelbrotCoord coord);
 // generate the value at a pixel coordinate and store it in the pixel store
 static inline void generateSetPixel(MandelbrotSet fractal, int row, int col);
 
+// the pixel of a fractal whose area contains coord, which may be outside the view
+// (then row or col is -1 or one past the end)
+static inline void pixelContaining(MandelbrotSet fractal, mandelbrotCoord coord, int *row, int *col);
+static inline int gridIndex(real position, int count);
+
 static inline bool generateBlockRow(MandelbrotSet fractal, int row, int colStart, int width);
 static inline bool generateBlockCol(MandelbrotSet fractal, int col, int rowStart, int height);
 
+// the previous score at a pixel position if its whole neighbourhood agrees, otherwise -1
+static inline int reusableScore(MandelbrotSet previous, int row, int col);
+
+static bool isValidProfile(const mandelbrotProfile *profile);
+
+// written only at startup, before other threads read it (see MandelbrotSet.h)
+static mandelbrotProfile currentProfile = { DEFAULT_TILE_WIDTH, DEFAULT_MINIMUM_BLOCK };
+
 
 MandelbrotSet createMandelbrotSet(int width, int height) {
    MandelbrotSet fractal = malloc(sizeof (struct mandelbrotSetData));
@@ -57,41 +144,233 @@ MandelbrotSet createMandelbrotSet(int width, int height) {
 
    fractal->isGenerated = false;
 
+   fractal->columnOffsets = malloc(sizeof (mandelbrotCoord) * width);
+   fractal->rowOffsets = malloc(sizeof (mandelbrotCoord) * height);
+   assert(fractal->columnOffsets != NULL && fractal->rowOffsets != NULL);
+
+   fractal->tileWidth = currentProfile.tileSize;
+   fractal->minimumBlock = currentProfile.minimumBlock;
+
+   fractal->tilesAcross = (width  + fractal->tileWidth - 1) / fractal->tileWidth;
+   fractal->tilesDown   = (height + fractal->tileWidth - 1) / fractal->tileWidth;
+   fractal->tileEpochs = calloc(fractal->tilesAcross * fractal->tilesDown, sizeof (atomic_uint));
+   assert(fractal->tileEpochs != NULL);
+   atomic_init(&fractal->epoch, NO_EPOCH + 1);
+
+   fractal->computedPixels = 0;
+
+   fractal->pendingCapacity = PENDING_BLOCKS;
+   fractal->pendingCount = 0;
+   fractal->pending = malloc(sizeof (pixelBlock) * fractal->pendingCapacity);
+   assert(fractal->pending != NULL);
+
+   fractal->stepTile = fractal->tilesAcross * fractal->tilesDown;
+   fractal->isStepFast = true;
+   fractal->stepEpoch = NO_EPOCH;
+
    return fractal;
 }
 
 void freeMandelbrotSet(MandelbrotSet fractal) {
    int row;
    freePixelScores(fractal);
+   free(fractal->columnOffsets);
+   free(fractal->rowOffsets);
+   free(fractal->pending);
+   free(fractal->tileEpochs);
    free(fractal);
 }
 
 void MandelbrotSet_setPosition(MandelbrotSet fractal, mandelbrotCoord center, int zoom) {
-   fractal->center = center;
-
    // calculate the mandelbrot-space distance between pixels
-   fractal->resolution = 1.0/((real)((unsigned long long)1 << zoom));
+   MandelbrotSet_setView(fractal, center, 1.0/((real)((unsigned long long)1 << zoom)));
+}
+
+void MandelbrotSet_setView(MandelbrotSet fractal, mandelbrotCoord center, real resolution) {
+   mandelbrotTransform transform;
 
    // width and height in fractal coordinates (from image coordinates)
-   real fractalWidth  = fractal->width  * fractal->resolution;
-   real fractalHeight = fractal->height * fractal->resolution;
+   real fractalWidth  = fractal->width  * resolution;
+   real fractalHeight = fractal->height * resolution;
 
    // top-left coordinate of the viewport rectangle in fractal coordinates
-   fractal->left = center.x - (fractalWidth/2.0);
-   fractal->top  = center.y + (fractalHeight/2.0);
+   transform.origin.x = center.x - (fractalWidth/2.0);
+   transform.origin.y = center.y + (fractalHeight/2.0);
+
+   transform.columnStep.x = resolution;
+   transform.columnStep.y = 0;
+   transform.rowStep.x = 0;
+   transform.rowStep.y = -resolution;
+
+   MandelbrotSet_setTransform(fractal, &transform);
+}
+
+void MandelbrotSet_setRotatedView(MandelbrotSet fractal, mandelbrotCoord center, real resolution, real radians) {
+   mandelbrotTransform transform;
+   real cosine = cosl(radians) * resolution;
+   real sine   = sinl(radians) * resolution;
+
+   // the axis-aligned steps turned anticlockwise
+   transform.columnStep.x = cosine;
+   transform.columnStep.y = sine;
+   transform.rowStep.x = sine;
+   transform.rowStep.y = -cosine;
+
+   // back from the center by half the image along each step
+   transform.origin.x = center.x - (fractal->width * transform.columnStep.x + fractal->height * transform.rowStep.x)/2.0;
+   transform.origin.y = center.y - (fractal->width * transform.columnStep.y + fractal->height * transform.rowStep.y)/2.0;
+
+   MandelbrotSet_setTransform(fractal, &transform);
+}
+
+void MandelbrotSet_setTransform(MandelbrotSet fractal, const mandelbrotTransform *transform) {
+   int row, col;
+
+   // parallel steps collapse the view onto a line, and pixelContaining can't invert it
+   assert(transform->columnStep.x * transform->rowStep.y - transform->rowStep.x * transform->columnStep.y != 0);
+
+   fractal->transform = *transform;
+
+   // each entry is computed outright rather than accumulated, so no error builds up
+   // across the view and a pixel's coordinate doesn't depend on the traversal order
+   // (the axis-aligned sums come out exactly as left + (resolution * col + resolution/2))
+   for (col = 0; col != fractal->width; ++col) {
+      fractal->columnOffsets[col].x = transform->origin.x + (transform->columnStep.x * col + transform->columnStep.x/2.0);
+      fractal->columnOffsets[col].y = transform->origin.y + (transform->columnStep.y * col + transform->columnStep.y/2.0);
+   }
+   for (row = 0; row != fractal->height; ++row) {
+      fractal->rowOffsets[row].x = transform->rowStep.x * row + transform->rowStep.x/2.0;
+      fractal->rowOffsets[row].y = transform->rowStep.y * row + transform->rowStep.y/2.0;
+   }
 
    fractal->isGenerated = false;
+   invalidateTiles(fractal);
+}
+
+void MandelbrotSet_getTransform(MandelbrotSet fractal, mandelbrotTransform *transform) {
+   *transform = fractal->transform;
 }
 
 
 void MandelbrotSet_generate(MandelbrotSet fractal) {
-   generateRectangle(fractal, 0, 0, fractal->width, fractal->height);
+   generateTiles(fractal, false);
    fractal->isGenerated = true;
 }
 
 void MandelbrotSet_fastGenerate(MandelbrotSet fractal) {
-   generateDivideAndConquer(fractal, 0, 0, fractal->width, fractal->height);
+   generateTiles(fractal, true);
+   fractal->isGenerated = true;
+}
+
+void MandelbrotSet_beginSteps(MandelbrotSet fractal, bool isFast) {
+   invalidateTiles(fractal);
+   // the scores are rewritten tile by tile from here, so a generate before this
+   // no longer describes them
+   fractal->isGenerated = false;
+   fractal->isStepFast = isFast;
+   fractal->stepEpoch = atomic_load_explicit(&fractal->epoch, memory_order_relaxed);
+   fractal->stepTile = 0;
+   fractal->pendingCount = 0;
+   queueTile(fractal, 0);
+}
+
+bool MandelbrotSet_step(MandelbrotSet fractal, long pixelBudget, long microseconds) {
+   int tileCount = fractal->tilesAcross * fractal->tilesDown;
+   long computedBefore = fractal->computedPixels;
+   long elapsed;
+   pixelBlock block;
+   struct timespec start, now;
+
+   // never begun, or the view, settings or scores changed since: the traversal
+   // (and any scores it finished) is stale, so start it over
+   if (fractal->stepEpoch != atomic_load_explicit(&fractal->epoch, memory_order_relaxed)) {
+      MandelbrotSet_beginSteps(fractal, fractal->isStepFast);
+   }
+
+   if (microseconds > 0) {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+   }
+
+   while (fractal->stepTile != tileCount) {
+      // always finish at least one block, so every step makes progress
+      block = fractal->pending[--fractal->pendingCount];
+      if (fractal->isStepFast) {
+         divideBlock(fractal, block);
+      } else {
+         generateRectangle(fractal, block.startX, block.startY, block.width, block.height);
+      }
+
+      if (fractal->pendingCount == 0) {
+         publishTile(fractal, fractal->stepTile);
+         fractal->stepTile++;
+         if (fractal->stepTile != tileCount) {
+            queueTile(fractal, fractal->stepTile);
+         }
+      }
+
+      if (pixelBudget > 0 && fractal->computedPixels - computedBefore >= pixelBudget) {
+         break;
+      }
+      if (microseconds > 0) {
+         clock_gettime(CLOCK_MONOTONIC, &now);
+         elapsed = (now.tv_sec - start.tv_sec) * 1000000L + (now.tv_nsec - start.tv_nsec) / 1000;
+         if (elapsed >= microseconds) {
+            break;
+         }
+      }
+   }
+
+   if (fractal->stepTile == tileCount) {
+      fractal->isGenerated = true;
+   }
+
+   return fractal->stepTile == tileCount;
+}
+
+double MandelbrotSet_getStepProgress(MandelbrotSet fractal) {
+   return (double)fractal->stepTile / (fractal->tilesAcross * fractal->tilesDown);
+}
+
+int MandelbrotSet_reproject(MandelbrotSet fractal, MandelbrotSet previous) {
+   int row, col;
+   int previousRow, previousCol;
+   int score;
+   int tile;
+   int computed = 0;
+   mandelbrotCoord coord;
+
+   assert(previous != fractal);
+
+   if (!previous->isGenerated || previous->maxIterations != fractal->maxIterations) {
+      // nothing trustworthy to reuse
+      MandelbrotSet_generate(fractal);
+      return fractal->width * fractal->height;
+   }
+
+   invalidateTiles(fractal);
+
+   for (row = 0; row != fractal->height; ++row) {
+      for (col = 0; col != fractal->width; ++col) {
+         coord.x = fractal->columnOffsets[col].x + fractal->rowOffsets[row].x;
+         coord.y = fractal->columnOffsets[col].y + fractal->rowOffsets[row].y;
+         pixelContaining(previous, coord, &previousRow, &previousCol);
+
+         score = reusableScore(previous, previousRow, previousCol);
+         if (score >= 0) {
+            fractal->pixelScores[row][col] = score;
+         } else {
+            generateSetPixel(fractal, row, col);
+            computed++;
+         }
+      }
+   }
+
+   for (tile = 0; tile != fractal->tilesAcross * fractal->tilesDown; ++tile) {
+      publishTile(fractal, tile);
+   }
    fractal->isGenerated = true;
+
+   return computed;
 }
 
 // returns a borrowed reference (freed when fractal is freed)
@@ -106,17 +385,152 @@ int **MandelbrotSet_getScores(MandelbrotSet fractal) {
 
 void MandelbrotSet_setMaxIterations(MandelbrotSet fractal, int maxIterations) {
    fractal->maxIterations = maxIterations;
+
+   // the scores no longer match the settings
+   fractal->isGenerated = false;
+   invalidateTiles(fractal);
+}
+
+int MandelbrotSet_scoreAt(MandelbrotSet fractal, mandelbrotCoord coord) {
+   return escapeScore(fractal, coord);
+}
+
+int MandelbrotSet_getTileSize(MandelbrotSet fractal) {
+   return fractal->tileWidth;
+}
+
+void MandelbrotSet_getTileGrid(MandelbrotSet fractal, int *across, int *down) {
+   *across = fractal->tilesAcross;
+   *down = fractal->tilesDown;
+}
+
+unsigned int MandelbrotSet_getEpoch(MandelbrotSet fractal) {
+   return atomic_load_explicit(&fractal->epoch, memory_order_acquire);
+}
+
+int MandelbrotSet_snapshotTiles(MandelbrotSet fractal, int **dest, bool *isReady, const bool *isSkipped) {
+   int tile, row;
+   int startX, startY, endX, endY;
+   int copied = 0;
+   int tileCount = fractal->tilesAcross * fractal->tilesDown;
+
+   unsigned int epoch = atomic_load_explicit(&fractal->epoch, memory_order_acquire);
+
+   for (tile = 0; tile != tileCount; ++tile) {
+      isReady[tile] = (isSkipped == NULL || !isSkipped[tile]) &&
+                      atomic_load_explicit(&fractal->tileEpochs[tile], memory_order_acquire) == epoch;
+      if (!isReady[tile]) {
+         continue;
+      }
+
+      startX = (tile % fractal->tilesAcross) * fractal->tileWidth;
+      startY = (tile / fractal->tilesAcross) * fractal->tileWidth;
+      endX = (startX + fractal->tileWidth < fractal->width)  ? startX + fractal->tileWidth : fractal->width;
+      endY = (startY + fractal->tileWidth < fractal->height) ? startY + fractal->tileWidth : fractal->height;
+
+      // copied blind, the recheck below decides whether the copy can be kept
+      for (row = startY; row != endY; ++row) {
+         memcpy(&dest[row][startX], &fractal->pixelScores[row][startX], sizeof (int) * (endX - startX));
+      }
+
+      // seqlock check: if any score was rewritten while copying, the tile may be torn
+      atomic_thread_fence(memory_order_acquire);
+      if (atomic_load_explicit(&fractal->epoch, memory_order_relaxed) != epoch) {
+         isReady[tile] = false;
+      } else {
+         copied++;
+      }
+   }
+
+   return copied;
+}
+
+void MandelbrotSet_getProfile(mandelbrotProfile *profile) {
+   *profile = currentProfile;
+}
+
+bool MandelbrotSet_setProfile(const mandelbrotProfile *profile) {
+   if (!isValidProfile(profile)) {
+      return false;
+   }
+
+   currentProfile = *profile;
+   return true;
+}
+
+bool MandelbrotSet_loadProfile(const char *path) {
+   char line[PROFILE_LINE];
+   char *value, *end;
+   long number;
+   mandelbrotProfile profile = currentProfile;
+   bool isValid = true;
+   FILE *file;
+
+   if (path == NULL) {
+      path = getenv(PROFILE_ENVIRONMENT);
+      if (path == NULL) {
+         return false;
+      }
+   }
+
+   file = fopen(path, "r");
+   if (file == NULL) {
+      return false;
+   }
+
+   while (isValid && fgets(line, sizeof line, file) != NULL) {
+      line[strcspn(line, "\r\n")] = '\0';
+      value = strchr(line, '=');
+      if (line[0] == '#' || value == NULL) {
+         continue;
+      }
+      *value++ = '\0';
+
+      number = strtol(value, &end, 10);
+      if (strcmp(line, "tileSize") == 0) {
+         profile.tileSize = (int)number;
+      } else if (strcmp(line, "minimumBlock") == 0) {
+         profile.minimumBlock = (int)number;
+      } else {
+         // written by a newer autotune, not ours to apply
+         continue;
+      }
+      isValid = (*value != '\0' && *end == '\0');
+   }
+   fclose(file);
+
+   return isValid && MandelbrotSet_setProfile(&profile);
+}
+
+bool MandelbrotSet_saveProfile(const char *path, const mandelbrotProfile *profile) {
+   bool isWritten;
+
+   FILE *file = fopen(path, "w");
+   if (file == NULL) {
+      return false;
+   }
+
+   fprintf(file, "# mandelbrot machine profile\n");
+   fprintf(file, "tileSize=%d\n", profile->tileSize);
+   fprintf(file, "minimumBlock=%d\n", profile->minimumBlock);
+
+   isWritten = !ferror(file);
+   isWritten = (fclose(file) == 0) && isWritten;
+
+   return isWritten;
 }
 
 
 // Static functions
 
+static bool isValidProfile(const mandelbrotProfile *profile) {
+   return profile->tileSize > 0 && profile->tileSize <= MAX_TILE_WIDTH &&
+          profile->minimumBlock >= 3 && profile->minimumBlock <= profile->tileSize;
+}
+
 static void freePixelScores(MandelbrotSet fractal) {
-   int row;
    if (fractal->pixelScores != NULL) {
-      for (row = 0; row != fractal->height; ++row) {
-         free(fractal->pixelScores[row]);
-      }
+      free(fractal->pixelScores[0]);
       free(fractal->pixelScores);
    }
 }
@@ -126,13 +540,79 @@ static void allocatePixelScores(MandelbrotSet fractal) {
    if (fractal->pixelScores == NULL) {
       // only need to allocate if not yet allocated
 
+      // rows are views into one block, so the whole image can be handed out contiguously
       fractal->pixelScores = (int **)malloc(sizeof(int*) * fractal->height);
-      for (row = 0; row != fractal->height; ++row) {
-         fractal->pixelScores[row] = (int *)malloc(sizeof(int) * fractal->width);
+      fractal->pixelScores[0] = (int *)malloc(sizeof(int) * fractal->width * fractal->height);
+      for (row = 1; row != fractal->height; ++row) {
+         fractal->pixelScores[row] = fractal->pixelScores[0] + (size_t)row * fractal->width;
+      }
+   }
+}
+
+static void generateTiles(MandelbrotSet fractal, bool isFast) {
+   int tileRow, tileCol;
+   int startX, startY, width, height;
+   int tile;
+   uint64_t tileStart = 0;
+   long computedBefore = 0;
+   bool isTracing = Trace_isEnabled();
+
+   // abandon any time-sliced traversal, this generates the whole view
+   fractal->pendingCount = 0;
+   fractal->stepTile = fractal->tilesAcross * fractal->tilesDown;
+
+   // regenerating the same view still rewrites tiles readers may be copying
+   invalidateTiles(fractal);
+
+   for (tileRow = 0; tileRow != fractal->tilesDown; ++tileRow) {
+      startY = tileRow * fractal->tileWidth;
+      height = (startY + fractal->tileWidth < fractal->height) ? fractal->tileWidth : fractal->height - startY;
+
+      for (tileCol = 0; tileCol != fractal->tilesAcross; ++tileCol) {
+         startX = tileCol * fractal->tileWidth;
+         width = (startX + fractal->tileWidth < fractal->width) ? fractal->tileWidth : fractal->width - startX;
+         tile = tileRow * fractal->tilesAcross + tileCol;
+
+         if (isTracing) {
+            tileStart = Trace_now();
+            computedBefore = fractal->computedPixels;
+         }
+
+         if (isFast) {
+            generateDivideAndConquer(fractal, startX, startY, width, height);
+         } else {
+            generateRectangle(fractal, startX, startY, width, height);
+         }
+
+         publishTile(fractal, tile);
+
+         if (isTracing) {
+            Trace_record(isFast ? "fastGenerate" : "generate", "tile", tileStart, tile,
+                         fractal->computedPixels - computedBefore);
+         }
       }
    }
 }
 
+static void invalidateTiles(MandelbrotSet fractal) {
+   // only the generating thread writes the epoch
+   unsigned int epoch = atomic_load_explicit(&fractal->epoch, memory_order_relaxed) + 1;
+   if (epoch == NO_EPOCH) {
+      // wrapped, skip the flag of tiles never generated
+      epoch++;
+   }
+   atomic_store_explicit(&fractal->epoch, epoch, memory_order_relaxed);
+
+   // keeps the bump ahead of the score stores that follow, so a reader whose copy
+   // saw any of them also sees the new epoch when it rechecks
+   atomic_thread_fence(memory_order_release);
+}
+
+static void publishTile(MandelbrotSet fractal, int tile) {
+   unsigned int epoch = atomic_load_explicit(&fractal->epoch, memory_order_relaxed);
+   atomic_store_explicit(&fractal->tileEpochs[tile], epoch, memory_order_release);
+}
+
 static void generateRectangle(MandelbrotSet fractal, int startX, int startY, int width, int height) {
    int row, col;
 
@@ -149,9 +629,22 @@ static void generateDivideAndConquer(MandelbrotSet fractal, int startX, int star
    // Mariani/Silver optimisation algorithm http://mrob.com/pub/muency/marianisilveralgorithm.html
    // may miss cusps narrower than 1 pixel
 
+   // an explicit stack rather than recursion, so the step API can stop between blocks
+   pushBlock(fractal, startX, startY, width, height);
+   while (fractal->pendingCount > 0) {
+      divideBlock(fractal, fractal->pending[--fractal->pendingCount]);
+   }
+}
+
+static void divideBlock(MandelbrotSet fractal, pixelBlock block) {
    int row, col;
    bool canSkip;
-   
+
+   int startX = block.startX;
+   int startY = block.startY;
+   int width  = block.width;
+   int height = block.height;
+
    int firstRow = startY;
    int lastRow  = startY + height - 1;
    int firstCol = startX;
@@ -159,7 +652,7 @@ static void generateDivideAndConquer(MandelbrotSet fractal, int startX, int star
 
    int newWidth, newHeight;
 
-   if (width < 3 || height < 3) {
+   if (width < fractal->minimumBlock || height < fractal->minimumBlock) {
       // stopping case, generate the slow way
       generateRectangle(fractal, startX, startY, width, height);
    } else {
@@ -186,15 +679,56 @@ static void generateDivideAndConquer(MandelbrotSet fractal, int startX, int star
          newWidth = width/2;
          newHeight = height/2;
 
-         // split and generate 4 quadrants
-         generateDivideAndConquer(fractal, startX, startY, newWidth, newHeight);
-         generateDivideAndConquer(fractal, startX+newWidth, startY, width-newWidth, newHeight);
-         generateDivideAndConquer(fractal, startX, startY+newHeight, newWidth, height-newHeight);
-         generateDivideAndConquer(fractal, startX+newWidth, startY+newHeight, width-newWidth, height-newHeight);
+         // split into 4 quadrants, pushed in reverse so the top left is generated first
+         pushBlock(fractal, startX+newWidth, startY+newHeight, width-newWidth, height-newHeight);
+         pushBlock(fractal, startX, startY+newHeight, newWidth, height-newHeight);
+         pushBlock(fractal, startX+newWidth, startY, width-newWidth, newHeight);
+         pushBlock(fractal, startX, startY, newWidth, newHeight);
       }
    }
 }
 
+static void pushBlock(MandelbrotSet fractal, int startX, int startY, int width, int height) {
+   pixelBlock *block;
+
+   if (fractal->pendingCount == fractal->pendingCapacity) {
+      fractal->pendingCapacity *= 2;
+      fractal->pending = realloc(fractal->pending, sizeof (pixelBlock) * fractal->pendingCapacity);
+      assert(fractal->pending != NULL);
+   }
+
+   block = &fractal->pending[fractal->pendingCount++];
+   block->startX = startX;
+   block->startY = startY;
+   block->width = width;
+   block->height = height;
+}
+
+static void queueTile(MandelbrotSet fractal, int tile) {
+   int row;
+   pixelBlock bounds;
+
+   getTileBounds(fractal, tile, &bounds);
+
+   if (fractal->isStepFast) {
+      pushBlock(fractal, bounds.startX, bounds.startY, bounds.width, bounds.height);
+   } else {
+      // a row at a time keeps each step short even with no pruning
+      for (row = bounds.startY + bounds.height - 1; row >= bounds.startY; --row) {
+         pushBlock(fractal, bounds.startX, row, bounds.width, 1);
+      }
+   }
+}
+
+static void getTileBounds(MandelbrotSet fractal, int tile, pixelBlock *bounds) {
+   bounds->startX = (tile % fractal->tilesAcross) * fractal->tileWidth;
+   bounds->startY = (tile / fractal->tilesAcross) * fractal->tileWidth;
+   bounds->width  = (bounds->startX + fractal->tileWidth < fractal->width)
+                    ? fractal->tileWidth : fractal->width - bounds->startX;
+   bounds->height = (bounds->startY + fractal->tileWidth < fractal->height)
+                    ? fractal->tileWidth : fractal->height - bounds->startY;
+}
+
 static inline bool generateBlockRow(MandelbrotSet fractal, int row, int colStart, int width) {
    bool isSameColor = true;
    int col = colStart;
@@ -223,17 +757,70 @@ static inline bool generateBlockCol(MandelbrotSet fractal, int col, int rowStart
    return isSameColor; 
 }
 
+static inline int reusableScore(MandelbrotSet previous, int row, int col) {
+   int neighbourRow, neighbourCol;
+   int score;
+
+   if (row < REPROJECT_RADIUS || row >= previous->height - REPROJECT_RADIUS ||
+       col < REPROJECT_RADIUS || col >= previous->width - REPROJECT_RADIUS) {
+      // missing from (or on the edge of) the previous view
+      return -1;
+   }
+
+   score = previous->pixelScores[row][col];
+   for (neighbourRow = row - REPROJECT_RADIUS; neighbourRow <= row + REPROJECT_RADIUS; ++neighbourRow) {
+      for (neighbourCol = col - REPROJECT_RADIUS; neighbourCol <= col + REPROJECT_RADIUS; ++neighbourCol) {
+         if (previous->pixelScores[neighbourRow][neighbourCol] != score) {
+            // near a boundary, too uncertain to copy
+            return -1;
+         }
+      }
+   }
+
+   return score;
+}
+
 static inline void generateSetPixel(MandelbrotSet fractal, int row, int col) {
    assert(fractal->pixelScores != NULL);
 
    mandelbrotCoord coord;
-   real halfResolution = fractal->resolution/2.0;
 
-   // generate coordinate, shift to the center of the pixel
-   coord.x = fractal->left + (fractal->resolution * col + halfResolution);
-   coord.y = fractal->top - (fractal->resolution * row + halfResolution);
+   // the center of the pixel, from its column's and row's share
+   coord.x = fractal->columnOffsets[col].x + fractal->rowOffsets[row].x;
+   coord.y = fractal->columnOffsets[col].y + fractal->rowOffsets[row].y;
 
    fractal->pixelScores[row][col] = escapeScore(fractal, coord);
+   fractal->computedPixels++;
+}
+
+static inline void pixelContaining(MandelbrotSet fractal, mandelbrotCoord coord, int *row, int *col) {
+   const mandelbrotTransform *transform = &fractal->transform;
+   real offsetX = coord.x - transform->origin.x;
+   real offsetY = coord.y - transform->origin.y;
+   real determinant;
+
+   if (transform->columnStep.y == 0 && transform->rowStep.x == 0) {
+      // axis-aligned, as every view but a rotated one
+      *col = gridIndex(offsetX / transform->columnStep.x, fractal->width);
+      *row = gridIndex(offsetY / transform->rowStep.y, fractal->height);
+   } else {
+      // solve offset = col * columnStep + row * rowStep
+      determinant = transform->columnStep.x * transform->rowStep.y - transform->rowStep.x * transform->columnStep.y;
+      *col = gridIndex((offsetX * transform->rowStep.y - offsetY * transform->rowStep.x) / determinant, fractal->width);
+      *row = gridIndex((offsetY * transform->columnStep.x - offsetX * transform->columnStep.y) / determinant, fractal->height);
+   }
+}
+
+static inline int gridIndex(real position, int count) {
+   // a view far from the other's lands way out of int range, and casting that (or a
+   // NaN) is undefined, so anything off the grid is pinned just beyond it
+   if (!(position >= 0)) {
+      return -1;
+   } else if (position >= count) {
+      return count;
+   }
+
+   return (int)floorl(position);
 }
 
 static inline int escapeScore(MandelbrotSet fractal, mandelbrotCoord coord) {
@@ -1,3 +1,12 @@
+#ifndef MANDELBROT_SET_H
+#define MANDELBROT_SET_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define DEFAULT_MAX_ITERATIONS 255
 
 typedef struct mandelbrotSetData *MandelbrotSet;
@@ -15,12 +24,113 @@ void freeMandelbrotSet(MandelbrotSet fractal);
 
 void MandelbrotSet_setPosition(MandelbrotSet fractal, mandelbrotCoord center, int zoom);
 
+// as setPosition, with an arbitrary distance between pixel centers
+void MandelbrotSet_setView(MandelbrotSet fractal, mandelbrotCoord center, real resolution);
+
+// General affine view, for rotated, sheared or non-square pixels: pixel (row, col) is
+// centered on origin + (col + 0.5) * columnStep + (row + 0.5) * rowStep, so origin is
+// the outer corner of pixel (0, 0). setView is the case columnStep = (resolution, 0),
+// rowStep = (0, -resolution). The steps must not be parallel (asserted).
+typedef struct {
+   mandelbrotCoord origin;
+   mandelbrotCoord columnStep;
+   mandelbrotCoord rowStep;
+} mandelbrotTransform;
+
+void MandelbrotSet_setTransform(MandelbrotSet fractal, const mandelbrotTransform *transform);
+
+void MandelbrotSet_getTransform(MandelbrotSet fractal, mandelbrotTransform *transform);
+
+// as setView, with the image rotated anticlockwise by radians about its center
+void MandelbrotSet_setRotatedView(MandelbrotSet fractal, mandelbrotCoord center, real resolution, real radians);
+
 
 void MandelbrotSet_generate(MandelbrotSet fractal);
 
 void MandelbrotSet_fastGenerate(MandelbrotSet fractal);
 
+// generate by reusing the scores of an already generated fractal (e.g. the previous animation frame)
+// pixels that land in a uniform neighbourhood of the previous scores are copied,
+// the rest (off the previous view, or near a boundary) are computed
+// returns the number of pixels that had to be computed
+int MandelbrotSet_reproject(MandelbrotSet fractal, MandelbrotSet previous);
+
+// Time-sliced generation, for a single-threaded host (a UI or event loop) that
+// can't block for a whole generate. Begin once per view, then call step until it
+// returns true; each step resumes the traversal exactly where the last stopped,
+// so the scores match generate or fastGenerate. Tiles are published as they
+// complete, as during generate. A step after the view or settings changed (or
+// without beginSteps) starts the traversal over, with the last strategy begun.
+
+void MandelbrotSet_beginSteps(MandelbrotSet fractal, bool isFast);
+
+// generate until about pixelBudget pixels have been computed or microseconds have
+// passed (0 for no limit on either), finishing at least one block (at most a tile's
+// border, or an exact tile's row) however small the budget
+// returns true once the whole view is generated
+bool MandelbrotSet_step(MandelbrotSet fractal, long pixelBudget, long microseconds);
+
+// fraction of tiles completed since beginSteps
+double MandelbrotSet_getStepProgress(MandelbrotSet fractal);
+
 // returns a borrowed reference (freed when fractal is freed)
+// rows are stored back to back, so scores[0] addresses all width * height scores
 int **MandelbrotSet_getScores(MandelbrotSet fractal);
 
-void MandelbrotSet_setMaxIterations(MandelbrotSet fractal, int maxIterations);
\ No newline at end of file
+void MandelbrotSet_setMaxIterations(MandelbrotSet fractal, int maxIterations);
+
+// the score of a single coordinate, using this fractal's settings
+// for renderers that sample the plane in their own pattern
+int MandelbrotSet_scoreAt(MandelbrotSet fractal, mandelbrotCoord coord);
+
+// Reading while generating: generation proceeds in square tiles, numbered row by row,
+// and each is published as it completes. Safe to call from another thread while
+// generate or fastGenerate runs; it never blocks the generating thread.
+// Every tile stops being ready the moment its scores may be rewritten: a new view
+// or maxIterations, or the start of another generate, beginSteps or reproject.
+
+int MandelbrotSet_getTileSize(MandelbrotSet fractal);
+
+void MandelbrotSet_getTileGrid(MandelbrotSet fractal, int *across, int *down);
+
+// changes whenever tiles stop being ready, so tiles snapshot while it reads the same
+// are still current; compare for equality only, it wraps
+unsigned int MandelbrotSet_getEpoch(MandelbrotSet fractal);
+
+// copy every tile already generated for the current view into dest (width x height),
+// except those isSkipped (one per tile, or NULL) marks, e.g. ones copied earlier
+// isReady (one per tile) says which tiles were copied; returns how many were
+int MandelbrotSet_snapshotTiles(MandelbrotSet fractal, int **dest, bool *isReady, const bool *isSkipped);
+
+// Machine profile: tuning picked per host by the autotune tool. Process wide,
+// it applies to fractals created after it is set. It is not synchronised: set it
+// once at startup, before any other thread (or pool task) creates a fractal.
+//
+// profile file | key=value per line, # comments, unknown keys ignored
+//    tileSize=64
+//    minimumBlock=3
+
+typedef struct {
+   // side of the square tiles generation proceeds (and is published) in
+   int tileSize;
+   // fastGenerate computes blocks narrower than this pixel by pixel instead of
+   // tracing their border, larger is slower but guesses less (at least 3)
+   int minimumBlock;
+} mandelbrotProfile;
+
+void MandelbrotSet_getProfile(mandelbrotProfile *profile);
+
+// returns false, changing nothing, if the profile is out of range
+bool MandelbrotSet_setProfile(const mandelbrotProfile *profile);
+
+// load and apply a profile file, NULL for the file named by $MANDELBROT_PROFILE
+// returns false, keeping the built-in defaults, if there is none or it is invalid
+bool MandelbrotSet_loadProfile(const char *path);
+
+bool MandelbrotSet_saveProfile(const char *path, const mandelbrotProfile *profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef MANDELBROT_SET_HPP
+#define MANDELBROT_SET_HPP
+
+// Header-only C++ layer over MandelbrotSet.h
+//
+//    mandelbrot::Renderer<mandelbrot::FastGenerate> renderer(640, 480);
+//    renderer.setPosition({ -0.5, 0.0 }, 8);
+//    std::span<const int> scores = renderer.generate();
+//
+// the strategy is a template parameter resolved at compile time,
+// each Renderer calls its kernel directly with no virtual dispatch
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <utility>
+
+#if __has_include(<mdspan>)
+#include <mdspan>
+#endif
+
+#include "MandelbrotSet.h"
+
+namespace mandelbrot {
+
+// strategies
+
+struct Generate {
+   static void run(MandelbrotSet fractal) {
+      MandelbrotSet_generate(fractal);
+   }
+};
+
+struct FastGenerate {
+   static void run(MandelbrotSet fractal) {
+      MandelbrotSet_fastGenerate(fractal);
+   }
+};
+
+// owns a MandelbrotSet, move-only
+template <class Strategy = FastGenerate>
+class Renderer {
+public:
+   Renderer(int width, int height)
+      : fractal(createMandelbrotSet(width, height)), rendererWidth(width), rendererHeight(height) {
+      if (fractal == nullptr) {
+         throw std::bad_alloc();
+      }
+   }
+
+   ~Renderer() {
+      if (fractal != nullptr) {
+         freeMandelbrotSet(fractal);
+      }
+   }
+
+   Renderer(const Renderer &) = delete;
+   Renderer &operator=(const Renderer &) = delete;
+
+   Renderer(Renderer &&other) noexcept
+      : fractal(std::exchange(other.fractal, nullptr)),
+        rendererWidth(other.rendererWidth), rendererHeight(other.rendererHeight) {}
+
+   Renderer &operator=(Renderer &&other) noexcept {
+      if (this != &other) {
+         if (fractal != nullptr) {
+            freeMandelbrotSet(fractal);
+         }
+         fractal = std::exchange(other.fractal, nullptr);
+         rendererWidth = other.rendererWidth;
+         rendererHeight = other.rendererHeight;
+      }
+      return *this;
+   }
+
+   void setPosition(mandelbrotCoord center, int zoom) {
+      MandelbrotSet_setPosition(fractal, center, zoom);
+   }
+
+   void setView(mandelbrotCoord center, real resolution) {
+      MandelbrotSet_setView(fractal, center, resolution);
+   }
+
+   void setTransform(const mandelbrotTransform &transform) {
+      MandelbrotSet_setTransform(fractal, &transform);
+   }
+
+   void setRotatedView(mandelbrotCoord center, real resolution, real radians) {
+      MandelbrotSet_setRotatedView(fractal, center, resolution, radians);
+   }
+
+   void setMaxIterations(int maxIterations) {
+      MandelbrotSet_setMaxIterations(fractal, maxIterations);
+   }
+
+   // generate with this renderer's strategy and return a view of the scores
+   std::span<const int> generate() {
+      Strategy::run(fractal);
+      return scores();
+   }
+
+   // all scores, row by row; empty if the view changed since the last generate
+   // the view stays valid until the renderer is regenerated, moved from or destroyed
+   std::span<const int> scores() const {
+      int **rows = MandelbrotSet_getScores(fractal);
+      if (rows == nullptr) {
+         return {};
+      }
+      return std::span<const int>(rows[0], static_cast<std::size_t>(rendererWidth) * rendererHeight);
+   }
+
+   std::span<const int> row(int index) const {
+      std::span<const int> all = scores();
+      if (all.empty()) {
+         return {};
+      }
+      return all.subspan(static_cast<std::size_t>(index) * rendererWidth, rendererWidth);
+   }
+
+#if defined(__cpp_lib_mdspan)
+   // scores indexed [row, column]
+   std::mdspan<const int, std::dextents<int, 2>> grid() const {
+      return std::mdspan<const int, std::dextents<int, 2>>(scores().data(), rendererHeight, rendererWidth);
+   }
+#endif
+
+   int width() const noexcept {
+      return rendererWidth;
+   }
+
+   int height() const noexcept {
+      return rendererHeight;
+   }
+
+   // the underlying handle, for the C APIs (still owned by this renderer)
+   MandelbrotSet get() const noexcept {
+      return fractal;
+   }
+
+private:
+   MandelbrotSet fractal;
+   int rendererWidth;
+   int rendererHeight;
+};
+
+}
+
+#endif
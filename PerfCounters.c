@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "PerfCounters.h"
+
+#define UNAVAILABLE -1
+
+struct perfCountersData {
+   int fds[PERF_COUNTER_COUNT];
+};
+
+// what perf returns with PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING
+typedef struct {
+   uint64_t value;
+   uint64_t timeEnabled;
+   uint64_t timeRunning;
+} counterValue;
+
+static const uint64_t counterConfigs[PERF_COUNTER_COUNT] = {
+   PERF_COUNT_HW_CPU_CYCLES,
+   PERF_COUNT_HW_INSTRUCTIONS,
+   PERF_COUNT_HW_BRANCH_MISSES,
+   PERF_COUNT_HW_CACHE_MISSES
+};
+
+static const char *counterNames[PERF_COUNTER_COUNT] = {
+   "cycles",
+   "instructions",
+   "branch-misses",
+   "cache-misses"
+};
+
+static int openCounter(uint64_t config);
+
+
+PerfCounters createPerfCounters(void) {
+   int counter;
+
+   PerfCounters counters = malloc(sizeof (struct perfCountersData));
+   assert(counters != NULL);
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      counters->fds[counter] = openCounter(counterConfigs[counter]);
+   }
+
+   return counters;
+}
+
+void freePerfCounters(PerfCounters counters) {
+   int counter;
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      if (counters->fds[counter] != UNAVAILABLE) {
+         close(counters->fds[counter]);
+      }
+   }
+   free(counters);
+}
+
+bool PerfCounters_isAvailable(PerfCounters counters) {
+   int counter;
+   bool isAvailable = false;
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      isAvailable = isAvailable || (counters->fds[counter] != UNAVAILABLE);
+   }
+
+   return isAvailable;
+}
+
+void PerfCounters_start(PerfCounters counters) {
+   int counter;
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      if (counters->fds[counter] != UNAVAILABLE) {
+         ioctl(counters->fds[counter], PERF_EVENT_IOC_RESET, 0);
+         ioctl(counters->fds[counter], PERF_EVENT_IOC_ENABLE, 0);
+      }
+   }
+}
+
+void PerfCounters_stop(PerfCounters counters, perfReading *reading) {
+   int counter;
+   counterValue value;
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      reading->isAvailable[counter] = false;
+      reading->values[counter] = 0;
+
+      if (counters->fds[counter] == UNAVAILABLE) {
+         continue;
+      }
+
+      ioctl(counters->fds[counter], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(counters->fds[counter], &value, sizeof value) == sizeof value && value.timeRunning > 0) {
+         reading->isAvailable[counter] = true;
+         reading->values[counter] = value.value;
+         if (value.timeRunning < value.timeEnabled) {
+            // the counter only ran part of the time, extrapolate
+            reading->values[counter] = (unsigned long long)
+               ((double)value.value * value.timeEnabled / value.timeRunning);
+         }
+      }
+   }
+}
+
+const char *PerfCounters_getName(perfCounter counter) {
+   return counterNames[counter];
+}
+
+
+// Static functions
+
+static int openCounter(uint64_t config) {
+   struct perf_event_attr attributes;
+   long fd;
+
+   memset(&attributes, 0, sizeof attributes);
+   attributes.size = sizeof attributes;
+   attributes.type = PERF_TYPE_HARDWARE;
+   attributes.config = config;
+   attributes.disabled = 1;
+   // user space only, which is all perf_event_paranoid=2 allows anyway
+   attributes.exclude_kernel = 1;
+   attributes.exclude_hv = 1;
+   attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+   // this thread, any CPU; fails with ENOENT/EACCES/ENOSYS in many containers and VMs
+   fd = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+
+   return (fd < 0) ? UNAVAILABLE : (int)fd;
+}
@@ -0,0 +1,40 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+
+// Hardware counters via perf_event_open, for this thread only and user space only.
+// Each counter is opened separately, so a host (or container) that only exposes
+// some of them still reports those; the rest read as unavailable.
+
+typedef enum {
+   PERF_CYCLES,
+   PERF_INSTRUCTIONS,
+   PERF_BRANCH_MISSES,
+   PERF_CACHE_MISSES,
+   PERF_COUNTER_COUNT
+} perfCounter;
+
+typedef struct {
+   bool isAvailable[PERF_COUNTER_COUNT];
+   // scaled up if the kernel multiplexed the counter
+   unsigned long long values[PERF_COUNTER_COUNT];
+} perfReading;
+
+typedef struct perfCountersData *PerfCounters;
+
+// never fails, unavailable counters are simply skipped
+PerfCounters createPerfCounters(void);
+
+void freePerfCounters(PerfCounters counters);
+
+// true if at least one counter could be opened
+bool PerfCounters_isAvailable(PerfCounters counters);
+
+void PerfCounters_start(PerfCounters counters);
+
+void PerfCounters_stop(PerfCounters counters, perfReading *reading);
+
+const char *PerfCounters_getName(perfCounter counter);
+
+#endif
@@ -0,0 +1,513 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "RenderCluster.h"
+#include "FileIO.h"
+
+#define IDLE -1
+
+// a worker that hasn't answered a tile in this long is taken to be hung
+#define DEFAULT_TILE_TIMEOUT_SECONDS 300
+
+// a tile that has cost this many workers is given up on rather than retried forever
+#define MAX_TILE_ATTEMPTS 3
+
+typedef struct {
+   pid_t pid;
+   int fd;
+   // index of the tile the worker is rendering, or IDLE
+   int tile;
+   // when the tile was sent, in seconds
+   double sentAt;
+} worker;
+
+// the tiles of one renderTiles
+typedef struct {
+   // tiles not yet handed out, taken from the end so tile 0 goes first
+   int *pending;
+   int pendingCount;
+   // failed attempts per tile
+   int *attempts;
+   // tiles given up on after MAX_TILE_ATTEMPTS
+   int failedCount;
+} tileQueue;
+
+struct renderClusterData {
+   worker *workers;
+   int workerCount;
+
+   int maxIterations;
+   clusterStrategy strategy;
+   int restartCount;
+   int tileTimeoutSeconds;
+
+   // set by a handler to end the current renderTiles early
+   bool isCancelled;
+
+   // reused grid for incoming tiles, rows point into one block
+   int **scores;
+   int scoresCapacity;
+};
+
+static void spawnWorker(RenderCluster cluster, int index);
+static void stopWorker(worker *process);
+
+// a worker failed: give its tile back to the queue, or give up on it after
+// MAX_TILE_ATTEMPTS, and start a replacement
+static void replaceWorker(RenderCluster cluster, int index, tileQueue *queue);
+
+// replace every worker whose tile is overdue, returns milliseconds until the next deadline
+static int replaceHungWorkers(RenderCluster cluster, tileQueue *queue);
+
+static double secondsNow(void);
+
+static bool sendTile(RenderCluster cluster, worker *process, const clusterTile *tile);
+static bool receiveTile(RenderCluster cluster, worker *process, const clusterTile *tile);
+
+// point a grid's rows into its block, growing it if needed
+static void prepareScores(RenderCluster cluster, int width, int height);
+
+
+RenderCluster createRenderCluster(int workerCount) {
+   int index;
+
+   assert(workerCount > 0);
+
+   RenderCluster cluster = malloc(sizeof (struct renderClusterData));
+   assert(cluster != NULL);
+
+   cluster->workerCount = workerCount;
+   cluster->workers = malloc(sizeof (worker) * workerCount);
+   assert(cluster->workers != NULL);
+
+   cluster->maxIterations = DEFAULT_MAX_ITERATIONS;
+   cluster->strategy = CLUSTER_STRATEGY_FAST_GENERATE;
+   cluster->restartCount = 0;
+   cluster->tileTimeoutSeconds = DEFAULT_TILE_TIMEOUT_SECONDS;
+   cluster->isCancelled = false;
+
+   cluster->scores = NULL;
+   cluster->scoresCapacity = 0;
+
+   for (index = 0; index != workerCount; ++index) {
+      cluster->workers[index].fd = -1;
+   }
+   for (index = 0; index != workerCount; ++index) {
+      spawnWorker(cluster, index);
+   }
+
+   return cluster;
+}
+
+void freeRenderCluster(RenderCluster cluster) {
+   int index;
+
+   // closing the socket is the shutdown signal
+   for (index = 0; index != cluster->workerCount; ++index) {
+      close(cluster->workers[index].fd);
+   }
+   for (index = 0; index != cluster->workerCount; ++index) {
+      waitpid(cluster->workers[index].pid, NULL, 0);
+   }
+
+   if (cluster->scores != NULL) {
+      free(cluster->scores[0]);
+      free(cluster->scores);
+   }
+   free(cluster->workers);
+   free(cluster);
+}
+
+void RenderCluster_setMaxIterations(RenderCluster cluster, int maxIterations) {
+   cluster->maxIterations = maxIterations;
+}
+
+void RenderCluster_setStrategy(RenderCluster cluster, clusterStrategy strategy) {
+   cluster->strategy = strategy;
+}
+
+void RenderCluster_setTileTimeout(RenderCluster cluster, int seconds) {
+   assert(seconds > 0);
+   cluster->tileTimeoutSeconds = seconds;
+}
+
+int RenderCluster_renderTiles(RenderCluster cluster, const clusterTile *tiles, int tileCount,
+                              clusterTileHandler handler, void *data) {
+   int index, polled, ready, timeout;
+   int handled = 0;
+   int unrendered;
+   bool isBroken = false;
+   worker *process;
+   tileQueue queue;
+
+   struct pollfd *waiting = malloc(sizeof (struct pollfd) * cluster->workerCount);
+   int *waitingWorker = malloc(sizeof (int) * cluster->workerCount);
+   queue.pending = malloc(sizeof (int) * (tileCount + 1));
+   queue.attempts = calloc(tileCount + 1, sizeof (int));
+   assert(queue.pending != NULL && queue.attempts != NULL && waiting != NULL && waitingWorker != NULL);
+
+   queue.pendingCount = 0;
+   queue.failedCount = 0;
+   for (index = tileCount - 1; index >= 0; --index) {
+      queue.pending[queue.pendingCount++] = index;
+   }
+
+   cluster->isCancelled = false;
+   while (handled + queue.failedCount < tileCount && !cluster->isCancelled) {
+      // keep every idle worker busy
+      for (index = 0; index != cluster->workerCount && queue.pendingCount > 0; ++index) {
+         process = &cluster->workers[index];
+         if (process->tile == IDLE) {
+            process->tile = queue.pending[--queue.pendingCount];
+            if (!sendTile(cluster, process, &tiles[process->tile])) {
+               replaceWorker(cluster, index, &queue);
+            }
+         }
+      }
+
+      timeout = replaceHungWorkers(cluster, &queue);
+      if (timeout == 0) {
+         // their tiles went back to the queue, hand them out before waiting again
+         continue;
+      }
+
+      polled = 0;
+      for (index = 0; index != cluster->workerCount; ++index) {
+         if (cluster->workers[index].tile != IDLE) {
+            waiting[polled].fd = cluster->workers[index].fd;
+            waiting[polled].events = POLLIN;
+            waitingWorker[polled] = index;
+            polled++;
+         }
+      }
+
+      if (polled == 0) {
+         // every send failed and its tile went back to the queue (or was given up
+         // on), hand them out again
+         continue;
+      }
+
+      // wake by the nearest deadline, so a hung worker can't stall the render
+      ready = poll(waiting, polled, timeout);
+      if (ready < 0 && errno != EINTR) {
+         // the coordinator itself can't wait on its workers, retrying won't help
+         perror("poll");
+         isBroken = true;
+         break;
+      }
+      if (ready <= 0) {
+         continue;
+      }
+
+      for (index = 0; index != polled && !cluster->isCancelled; ++index) {
+         if (waiting[index].revents == 0) {
+            continue;
+         }
+
+         process = &cluster->workers[waitingWorker[index]];
+         if (receiveTile(cluster, process, &tiles[process->tile])) {
+            handler(&tiles[process->tile], cluster->scores, data);
+            process->tile = IDLE;
+            handled++;
+         } else {
+            // died (or answered garbage) mid-tile
+            replaceWorker(cluster, waitingWorker[index], &queue);
+         }
+      }
+   }
+
+   if (cluster->isCancelled || isBroken) {
+      // busy workers would answer into the next render, start them afresh instead
+      for (index = 0; index != cluster->workerCount; ++index) {
+         if (cluster->workers[index].tile != IDLE) {
+            stopWorker(&cluster->workers[index]);
+            spawnWorker(cluster, index);
+         }
+      }
+   }
+
+   // a cancel abandons the rest by request, a broken render counts them as failed
+   unrendered = isBroken ? tileCount - handled : queue.failedCount;
+
+   free(waitingWorker);
+   free(waiting);
+   free(queue.attempts);
+   free(queue.pending);
+
+   return unrendered;
+}
+
+void RenderCluster_cancel(RenderCluster cluster) {
+   cluster->isCancelled = true;
+}
+
+int RenderCluster_renderViewport(RenderCluster cluster, mandelbrotCoord center, int zoom,
+                                 int width, int height, int tileSize,
+                                 clusterTileHandler handler, void *data) {
+   clusterTile *tiles;
+   int tileCount = RenderCluster_splitViewport(center, zoom, width, height, tileSize, &tiles);
+
+   int unrendered = RenderCluster_renderTiles(cluster, tiles, tileCount, handler, data);
+
+   free(tiles);
+   return unrendered;
+}
+
+int RenderCluster_splitViewport(mandelbrotCoord center, int zoom, int width, int height, int tileSize,
+                                clusterTile **tiles) {
+   int left, top;
+   int tileCount = 0;
+   clusterTile *tile;
+
+   real resolution = 1.0/((real)((unsigned long long)1 << zoom));
+   real viewLeft = center.x - (width  * resolution)/2.0;
+   real viewTop  = center.y + (height * resolution)/2.0;
+
+   int across = (width + tileSize - 1) / tileSize;
+   int down = (height + tileSize - 1) / tileSize;
+   *tiles = malloc(sizeof (clusterTile) * across * down);
+   assert(*tiles != NULL);
+
+   for (top = 0; top < height; top += tileSize) {
+      for (left = 0; left < width; left += tileSize) {
+         tile = &(*tiles)[tileCount];
+         tile->id = tileCount;
+         tile->left = left;
+         tile->top = top;
+         tile->width = (left + tileSize <= width) ? tileSize : width - left;
+         tile->height = (top + tileSize <= height) ? tileSize : height - top;
+         tile->zoom = zoom;
+
+         // center the tile on the same pixel grid as the whole viewport
+         tile->center.x = viewLeft + (left + tile->width/2.0) * resolution;
+         tile->center.y = viewTop - (top + tile->height/2.0) * resolution;
+
+         tileCount++;
+      }
+   }
+
+   return tileCount;
+}
+
+int RenderCluster_getRestartCount(RenderCluster cluster) {
+   return cluster->restartCount;
+}
+
+void RenderCluster_workerMain(int fd) {
+   tileRequestMessage request;
+   tileResponseMessage response;
+   mandelbrotCoord center;
+   int row;
+   int **scores;
+   bool isOpen = true;
+
+   MandelbrotSet fractal = NULL;
+   int width = 0;
+   int height = 0;
+
+   while (isOpen && FileIO_readFully(fd, &request, sizeof request)) {
+      if (request.magic != CLUSTER_MAGIC || request.realSize != sizeof (real)) {
+         break;
+      }
+
+      if (fractal == NULL || request.width != width || request.height != height) {
+         if (fractal != NULL) {
+            freeMandelbrotSet(fractal);
+         }
+         width = request.width;
+         height = request.height;
+         fractal = createMandelbrotSet(width, height);
+      }
+
+      center.x = request.centerX;
+      center.y = request.centerY;
+      MandelbrotSet_setMaxIterations(fractal, request.maxIterations);
+      MandelbrotSet_setPosition(fractal, center, request.zoom);
+
+      if (request.strategy == CLUSTER_STRATEGY_GENERATE) {
+         MandelbrotSet_generate(fractal);
+      } else {
+         MandelbrotSet_fastGenerate(fractal);
+      }
+      scores = MandelbrotSet_getScores(fractal);
+
+      response.magic = CLUSTER_MAGIC;
+      response.tileId = request.tileId;
+      response.width = width;
+      response.height = height;
+      isOpen = FileIO_writeFully(fd, &response, sizeof response);
+
+      for (row = 0; isOpen && row != height; ++row) {
+         isOpen = FileIO_writeFully(fd, scores[row], sizeof (int32_t) * width);
+      }
+   }
+
+   if (fractal != NULL) {
+      freeMandelbrotSet(fractal);
+   }
+   close(fd);
+}
+
+
+// Static functions
+
+static void spawnWorker(RenderCluster cluster, int index) {
+   int sockets[2];
+   int other;
+   pid_t pid;
+   worker *process = &cluster->workers[index];
+
+   assert(sizeof (int) == sizeof (int32_t));
+
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+      perror("socketpair");
+      exit(EXIT_FAILURE);
+   }
+
+   // don't let buffered output be flushed twice
+   fflush(NULL);
+
+   pid = fork();
+   if (pid < 0) {
+      perror("fork");
+      exit(EXIT_FAILURE);
+   } else if (pid == 0) {
+      // the worker only keeps its own end, so it sees EOF when the coordinator goes away
+      close(sockets[0]);
+      for (other = 0; other != cluster->workerCount; ++other) {
+         if (cluster->workers[other].fd >= 0) {
+            close(cluster->workers[other].fd);
+         }
+      }
+      RenderCluster_workerMain(sockets[1]);
+      _exit(EXIT_SUCCESS);
+   }
+
+   close(sockets[1]);
+   process->pid = pid;
+   process->fd = sockets[0];
+   process->tile = IDLE;
+}
+
+static int replaceHungWorkers(RenderCluster cluster, tileQueue *queue) {
+   int index;
+   double deadline;
+   double now = secondsNow();
+   double nearest = cluster->tileTimeoutSeconds;
+   bool isReplaced = false;
+
+   for (index = 0; index != cluster->workerCount; ++index) {
+      if (cluster->workers[index].tile == IDLE) {
+         continue;
+      }
+
+      deadline = cluster->workers[index].sentAt + cluster->tileTimeoutSeconds;
+      if (deadline <= now) {
+         // alive but not answering, its tile goes to a replacement
+         replaceWorker(cluster, index, queue);
+         isReplaced = true;
+      } else if (deadline - now < nearest) {
+         nearest = deadline - now;
+      }
+   }
+
+   // round up, so the poll doesn't wake just short of the deadline
+   return isReplaced ? 0 : (int)(nearest * 1000) + 1;
+}
+
+static double secondsNow(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void stopWorker(worker *process) {
+   close(process->fd);
+   process->fd = -1;
+   kill(process->pid, SIGKILL);
+   waitpid(process->pid, NULL, 0);
+}
+
+static void replaceWorker(RenderCluster cluster, int index, tileQueue *queue) {
+   worker *process = &cluster->workers[index];
+
+   if (process->tile != IDLE) {
+      // a tile that keeps killing workers (or outlasting the timeout) would
+      // otherwise be requeued forever
+      if (++queue->attempts[process->tile] < MAX_TILE_ATTEMPTS) {
+         queue->pending[queue->pendingCount++] = process->tile;
+      } else {
+         queue->failedCount++;
+      }
+   }
+
+   stopWorker(process);
+   spawnWorker(cluster, index);
+   cluster->restartCount++;
+}
+
+static bool sendTile(RenderCluster cluster, worker *process, const clusterTile *tile) {
+   tileRequestMessage request;
+
+   request.magic = CLUSTER_MAGIC;
+   request.realSize = sizeof (real);
+   request.tileId = tile->id;
+   request.strategy = cluster->strategy;
+   request.width = tile->width;
+   request.height = tile->height;
+   request.zoom = tile->zoom;
+   request.maxIterations = cluster->maxIterations;
+   request.centerX = tile->center.x;
+   request.centerY = tile->center.y;
+
+   process->sentAt = secondsNow();
+   return FileIO_writeFully(process->fd, &request, sizeof request);
+}
+
+static bool receiveTile(RenderCluster cluster, worker *process, const clusterTile *tile) {
+   tileResponseMessage response;
+
+   if (!FileIO_readFully(process->fd, &response, sizeof response) ||
+       response.magic != CLUSTER_MAGIC || response.tileId != tile->id ||
+       response.width != tile->width || response.height != tile->height) {
+      return false;
+   }
+
+   prepareScores(cluster, tile->width, tile->height);
+
+   return FileIO_readFully(process->fd, cluster->scores[0], sizeof (int32_t) * tile->width * tile->height);
+}
+
+static void prepareScores(RenderCluster cluster, int width, int height) {
+   int row;
+   int size = width * height;
+
+   if (size > cluster->scoresCapacity || cluster->scores == NULL) {
+      if (cluster->scores != NULL) {
+         free(cluster->scores[0]);
+         free(cluster->scores);
+      }
+      cluster->scores = malloc(sizeof (int *) * height);
+      assert(cluster->scores != NULL);
+      cluster->scores[0] = malloc(sizeof (int) * size);
+      assert(cluster->scores[0] != NULL);
+      cluster->scoresCapacity = size;
+   } else {
+      cluster->scores = realloc(cluster->scores, sizeof (int *) * height);
+      assert(cluster->scores != NULL);
+   }
+
+   for (row = 1; row != height; ++row) {
+      cluster->scores[row] = cluster->scores[0] + (size_t)row * width;
+   }
+}
@@ -0,0 +1,105 @@
+#ifndef RENDER_CLUSTER_H
+#define RENDER_CLUSTER_H
+
+#include <stdint.h>
+
+#include "MandelbrotSet.h"
+
+// A coordinator handing tiles to worker processes over Unix-domain sockets.
+//
+// Wire protocol, fields in host byte order:
+//
+//    request  | tileRequestMessage
+//    response | tileResponseMessage, then width * height int32 scores row by row
+//
+// coordinates are sent as raw `real`, realSize lets a worker reject a peer
+// whose long double layout differs
+
+#define CLUSTER_MAGIC 0x4d42434c  // "MBCL"
+
+typedef enum {
+   CLUSTER_STRATEGY_GENERATE,
+   CLUSTER_STRATEGY_FAST_GENERATE
+} clusterStrategy;
+
+typedef struct {
+   uint32_t magic;
+   uint32_t realSize;
+   uint32_t tileId;
+   uint32_t strategy;
+   int32_t width;
+   int32_t height;
+   int32_t zoom;
+   int32_t maxIterations;
+   real centerX;
+   real centerY;
+} tileRequestMessage;
+
+typedef struct {
+   uint32_t magic;
+   uint32_t tileId;
+   int32_t width;
+   int32_t height;
+} tileResponseMessage;
+
+typedef struct {
+   uint32_t id;
+   mandelbrotCoord center;
+   int zoom;
+   int width;
+   int height;
+   // where the tile goes in the overall image
+   int left;
+   int top;
+} clusterTile;
+
+// called on the coordinator as each tile arrives, scores is borrowed for the call
+typedef void (*clusterTileHandler)(const clusterTile *tile, int **scores, void *data);
+
+typedef struct renderClusterData *RenderCluster;
+
+// forks workerCount local worker processes
+RenderCluster createRenderCluster(int workerCount);
+
+// shuts the workers down and reaps them
+void freeRenderCluster(RenderCluster cluster);
+
+void RenderCluster_setMaxIterations(RenderCluster cluster, int maxIterations);
+
+void RenderCluster_setStrategy(RenderCluster cluster, clusterStrategy strategy);
+
+// a worker that takes longer than this over one tile is presumed hung, killed and
+// replaced, and the tile rendered again (default 300 seconds); a tile that does so
+// (or kills its worker) three times is given up on
+void RenderCluster_setTileTimeout(RenderCluster cluster, int seconds);
+
+// render every tile, handing each to the handler in completion order
+// tiles held by a worker that dies are given to a replacement worker
+// returns the number of tiles never handed to the handler because they failed
+// every attempt, or because the coordinator couldn't wait on its workers (every
+// tile unfinished then); tiles abandoned by a cancel aren't counted
+int RenderCluster_renderTiles(RenderCluster cluster, const clusterTile *tiles, int tileCount,
+                              clusterTileHandler handler, void *data);
+
+// from a handler: return from the current render as soon as the handler does,
+// abandoning the tiles not yet handed over
+void RenderCluster_cancel(RenderCluster cluster);
+
+// split a viewport (as for MandelbrotSet_setPosition) into tiles on its pixel grid,
+// numbered row by row from 0; returns the tile count, *tiles must be freed by the caller
+int RenderCluster_splitViewport(mandelbrotCoord center, int zoom, int width, int height, int tileSize,
+                                clusterTile **tiles);
+
+// split a viewport into tiles and render them, returns as renderTiles
+int RenderCluster_renderViewport(RenderCluster cluster, mandelbrotCoord center, int zoom,
+                                 int width, int height, int tileSize,
+                                 clusterTileHandler handler, void *data);
+
+// number of workers replaced after dying
+int RenderCluster_getRestartCount(RenderCluster cluster);
+
+// serve tile requests on a connected socket until it closes
+// (the body of every worker, usable by a standalone worker process)
+void RenderCluster_workerMain(int fd);
+
+#endif
@@ -0,0 +1,343 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#include "ScorePyramid.h"
+
+struct scorePyramidData {
+   int **scores;
+   int width;
+   int height;
+   int maxIterations;
+
+   // one bit per pixel, set once the pixel is folded in
+   unsigned char *isIndexed;
+
+   // levels[0] is the finest, levels[levelCount - 1] a single cell
+   int levelCount;
+   scoreSummary **levels;
+   int *levelAcross;
+   int *levelDown;
+
+   // the fractal tiles already folded in, sized on first use
+   bool *isReady;
+   bool *isTileAdded;
+   int tileCount;
+
+   // the fractal epoch they were snapshot at, once a snapshot has been taken
+   unsigned int epoch;
+   bool hasEpoch;
+};
+
+// rebuild every cell from level up that covers a rectangle of level - 1 cells
+static void updateParents(ScorePyramid pyramid, int level, int firstX, int firstY, int lastX, int lastY);
+
+static void queryCell(ScorePyramid pyramid, int level, int cellX, int cellY,
+                      int left, int top, int right, int bottom, scoreSummary *summary);
+
+static void mergeSummary(scoreSummary *into, const scoreSummary *from);
+static void mergeScore(scoreSummary *into, int score, int maxIterations);
+static void clearSummary(scoreSummary *summary);
+
+static inline bool isPixelIndexed(ScorePyramid pyramid, int row, int col);
+
+
+ScorePyramid createScorePyramid(int **scores, int width, int height, int maxIterations) {
+   int level, across, down;
+
+   ScorePyramid pyramid = malloc(sizeof (struct scorePyramidData));
+   assert(pyramid != NULL);
+
+   pyramid->scores = scores;
+   pyramid->width = width;
+   pyramid->height = height;
+   pyramid->maxIterations = maxIterations;
+
+   pyramid->isIndexed = malloc(((size_t)width * height + 7) / 8);
+   assert(pyramid->isIndexed != NULL);
+
+   // halve the grid until one cell covers the whole frame
+   across = (width  + PYRAMID_CELL - 1) / PYRAMID_CELL;
+   down   = (height + PYRAMID_CELL - 1) / PYRAMID_CELL;
+   pyramid->levelCount = 1;
+   while (across > 1 || down > 1) {
+      across = (across + 1) / 2;
+      down = (down + 1) / 2;
+      pyramid->levelCount++;
+   }
+
+   pyramid->levels = malloc(sizeof (scoreSummary *) * pyramid->levelCount);
+   pyramid->levelAcross = malloc(sizeof (int) * pyramid->levelCount);
+   pyramid->levelDown = malloc(sizeof (int) * pyramid->levelCount);
+   assert(pyramid->levels != NULL && pyramid->levelAcross != NULL && pyramid->levelDown != NULL);
+
+   across = (width  + PYRAMID_CELL - 1) / PYRAMID_CELL;
+   down   = (height + PYRAMID_CELL - 1) / PYRAMID_CELL;
+   for (level = 0; level != pyramid->levelCount; ++level) {
+      pyramid->levelAcross[level] = across;
+      pyramid->levelDown[level] = down;
+      pyramid->levels[level] = malloc(sizeof (scoreSummary) * across * down);
+      assert(pyramid->levels[level] != NULL);
+
+      across = (across + 1) / 2;
+      down = (down + 1) / 2;
+   }
+
+   pyramid->isReady = NULL;
+   pyramid->isTileAdded = NULL;
+   pyramid->tileCount = 0;
+   pyramid->hasEpoch = false;
+
+   ScorePyramid_clear(pyramid);
+
+   return pyramid;
+}
+
+void freeScorePyramid(ScorePyramid pyramid) {
+   int level;
+
+   for (level = 0; level != pyramid->levelCount; ++level) {
+      free(pyramid->levels[level]);
+   }
+   free(pyramid->levels);
+   free(pyramid->levelAcross);
+   free(pyramid->levelDown);
+   free(pyramid->isIndexed);
+   free(pyramid->isReady);
+   free(pyramid->isTileAdded);
+   free(pyramid);
+}
+
+void ScorePyramid_clear(ScorePyramid pyramid) {
+   int level, cell;
+
+   memset(pyramid->isIndexed, 0, ((size_t)pyramid->width * pyramid->height + 7) / 8);
+
+   for (level = 0; level != pyramid->levelCount; ++level) {
+      for (cell = 0; cell != pyramid->levelAcross[level] * pyramid->levelDown[level]; ++cell) {
+         clearSummary(&pyramid->levels[level][cell]);
+      }
+   }
+
+   if (pyramid->isTileAdded != NULL) {
+      memset(pyramid->isTileAdded, 0, sizeof (bool) * pyramid->tileCount);
+   }
+}
+
+void ScorePyramid_addRegion(ScorePyramid pyramid, int left, int top, int width, int height) {
+   int row, col;
+   size_t bit;
+   int right = left + width;
+   int bottom = top + height;
+   scoreSummary *cells = pyramid->levels[0];
+   int across = pyramid->levelAcross[0];
+
+   left = (left < 0) ? 0 : left;
+   top = (top < 0) ? 0 : top;
+   right = (right > pyramid->width) ? pyramid->width : right;
+   bottom = (bottom > pyramid->height) ? pyramid->height : bottom;
+   if (left >= right || top >= bottom) {
+      return;
+   }
+
+   for (row = top; row != bottom; ++row) {
+      for (col = left; col != right; ++col) {
+         if (isPixelIndexed(pyramid, row, col)) {
+            continue;
+         }
+         bit = (size_t)row * pyramid->width + col;
+         pyramid->isIndexed[bit / 8] |= (unsigned char)(1 << (bit % 8));
+
+         mergeScore(&cells[(row / PYRAMID_CELL) * across + col / PYRAMID_CELL],
+                    pyramid->scores[row][col], pyramid->maxIterations);
+      }
+   }
+
+   updateParents(pyramid, 1, left / PYRAMID_CELL, top / PYRAMID_CELL,
+                 (right - 1) / PYRAMID_CELL, (bottom - 1) / PYRAMID_CELL);
+}
+
+int ScorePyramid_addCompletedTiles(ScorePyramid pyramid, MandelbrotSet fractal) {
+   int tile, across, down, tileSize;
+   int added = 0;
+   unsigned int epoch;
+
+   MandelbrotSet_getTileGrid(fractal, &across, &down);
+   tileSize = MandelbrotSet_getTileSize(fractal);
+
+   epoch = MandelbrotSet_getEpoch(fractal);
+   if (pyramid->hasEpoch && epoch != pyramid->epoch) {
+      // a new view or generate, everything indexed describes the old one
+      ScorePyramid_clear(pyramid);
+   }
+   pyramid->epoch = epoch;
+   pyramid->hasEpoch = true;
+
+   if (pyramid->tileCount != across * down) {
+      free(pyramid->isReady);
+      free(pyramid->isTileAdded);
+      pyramid->tileCount = across * down;
+      pyramid->isReady = malloc(sizeof (bool) * pyramid->tileCount);
+      pyramid->isTileAdded = calloc(pyramid->tileCount, sizeof (bool));
+      assert(pyramid->isReady != NULL && pyramid->isTileAdded != NULL);
+   }
+
+   // tiles already added aren't copied again
+   MandelbrotSet_snapshotTiles(fractal, pyramid->scores, pyramid->isReady, pyramid->isTileAdded);
+
+   if (MandelbrotSet_getEpoch(fractal) != epoch) {
+      // invalidated under the snapshot, which may have mixed the next generate's tiles in
+      ScorePyramid_clear(pyramid);
+      pyramid->hasEpoch = false;
+      return 0;
+   }
+
+   for (tile = 0; tile != pyramid->tileCount; ++tile) {
+      if (pyramid->isReady[tile]) {
+         ScorePyramid_addRegion(pyramid, (tile % across) * tileSize, (tile / across) * tileSize, tileSize, tileSize);
+         pyramid->isTileAdded[tile] = true;
+         added++;
+      }
+   }
+
+   return added;
+}
+
+bool ScorePyramid_query(ScorePyramid pyramid, int left, int top, int width, int height, scoreSummary *summary) {
+   int right = left + width;
+   int bottom = top + height;
+   int topLevel = pyramid->levelCount - 1;
+
+   left = (left < 0) ? 0 : left;
+   top = (top < 0) ? 0 : top;
+   right = (right > pyramid->width) ? pyramid->width : right;
+   bottom = (bottom > pyramid->height) ? pyramid->height : bottom;
+
+   clearSummary(summary);
+   if (left >= right || top >= bottom) {
+      return true;
+   }
+
+   queryCell(pyramid, topLevel, 0, 0, left, top, right, bottom, summary);
+
+   return summary->pixels == (long)(right - left) * (bottom - top);
+}
+
+int ScorePyramid_getLevelCount(ScorePyramid pyramid) {
+   return pyramid->levelCount;
+}
+
+const scoreSummary *ScorePyramid_getLevel(ScorePyramid pyramid, int level, int *across, int *down) {
+   assert(level >= 0 && level < pyramid->levelCount);
+
+   *across = pyramid->levelAcross[level];
+   *down = pyramid->levelDown[level];
+
+   return pyramid->levels[level];
+}
+
+
+// Static functions
+
+static void updateParents(ScorePyramid pyramid, int level, int firstX, int firstY, int lastX, int lastY) {
+   int cellX, cellY, childX, childY;
+   scoreSummary *cell;
+   const scoreSummary *children;
+   int childAcross, childDown;
+
+   for (; level != pyramid->levelCount; ++level) {
+      firstX /= 2;
+      firstY /= 2;
+      lastX /= 2;
+      lastY /= 2;
+
+      children = pyramid->levels[level - 1];
+      childAcross = pyramid->levelAcross[level - 1];
+      childDown = pyramid->levelDown[level - 1];
+
+      // rebuilt from the children rather than patched, so adds in any order agree
+      for (cellY = firstY; cellY <= lastY; ++cellY) {
+         for (cellX = firstX; cellX <= lastX; ++cellX) {
+            cell = &pyramid->levels[level][cellY * pyramid->levelAcross[level] + cellX];
+            clearSummary(cell);
+            for (childY = 2*cellY; childY != 2*cellY + 2 && childY < childDown; ++childY) {
+               for (childX = 2*cellX; childX != 2*cellX + 2 && childX < childAcross; ++childX) {
+                  mergeSummary(cell, &children[childY * childAcross + childX]);
+               }
+            }
+         }
+      }
+   }
+}
+
+static void queryCell(ScorePyramid pyramid, int level, int cellX, int cellY,
+                      int left, int top, int right, int bottom, scoreSummary *summary) {
+   int row, col, childX, childY;
+   int cellSize = PYRAMID_CELL << level;
+   int cellLeft = cellX * cellSize;
+   int cellTop = cellY * cellSize;
+   int cellRight = cellLeft + cellSize;
+   int cellBottom = cellTop + cellSize;
+   const scoreSummary *cell = &pyramid->levels[level][cellY * pyramid->levelAcross[level] + cellX];
+
+   if (cellLeft >= right || cellRight <= left || cellTop >= bottom || cellBottom <= top || cell->pixels == 0) {
+      // outside the rectangle, or nothing indexed under it
+      return;
+   }
+
+   if (cellLeft >= left && cellRight <= right && cellTop >= top && cellBottom <= bottom) {
+      mergeSummary(summary, cell);
+   } else if (level == 0) {
+      // a cell straddling the border, look at its pixels
+      for (row = (cellTop > top) ? cellTop : top; row != ((cellBottom < bottom) ? cellBottom : bottom); ++row) {
+         for (col = (cellLeft > left) ? cellLeft : left; col != ((cellRight < right) ? cellRight : right); ++col) {
+            if (isPixelIndexed(pyramid, row, col)) {
+               mergeScore(summary, pyramid->scores[row][col], pyramid->maxIterations);
+            }
+         }
+      }
+   } else {
+      for (childY = 2*cellY; childY != 2*cellY + 2 && childY < pyramid->levelDown[level - 1]; ++childY) {
+         for (childX = 2*cellX; childX != 2*cellX + 2 && childX < pyramid->levelAcross[level - 1]; ++childX) {
+            queryCell(pyramid, level - 1, childX, childY, left, top, right, bottom, summary);
+         }
+      }
+   }
+}
+
+static void mergeSummary(scoreSummary *into, const scoreSummary *from) {
+   if (from->pixels == 0) {
+      return;
+   }
+
+   into->minimum = (from->minimum < into->minimum) ? from->minimum : into->minimum;
+   into->maximum = (from->maximum > into->maximum) ? from->maximum : into->maximum;
+   into->inSet += from->inSet;
+   into->pixels += from->pixels;
+}
+
+static void mergeScore(scoreSummary *into, int score, int maxIterations) {
+   into->minimum = (score < into->minimum) ? score : into->minimum;
+   into->maximum = (score > into->maximum) ? score : into->maximum;
+   if (score == maxIterations) {
+      into->inSet++;
+   }
+   into->pixels++;
+}
+
+static void clearSummary(scoreSummary *summary) {
+   // so the first merged score sets both
+   summary->minimum = INT_MAX;
+   summary->maximum = INT_MIN;
+   summary->inSet = 0;
+   summary->pixels = 0;
+}
+
+static inline bool isPixelIndexed(ScorePyramid pyramid, int row, int col) {
+   size_t bit = (size_t)row * pyramid->width + col;
+
+   return (pyramid->isIndexed[bit / 8] & (1 << (bit % 8))) != 0;
+}
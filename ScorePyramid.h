@@ -0,0 +1,62 @@
+#ifndef SCORE_PYRAMID_H
+#define SCORE_PYRAMID_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+
+// A min/max/count mip pyramid over a frame of scores, for answering region
+// questions ("any set pixels in this box?", "deepest dwell here?") without
+// scanning the frame, and for drawing coarse overviews.
+//
+// The pyramid indexes a score grid the caller owns (typically the grid a UI
+// snapshots a generating fractal into) and is filled in incrementally, region
+// by region or tile by tile as generation completes them. Level 0 summarises
+// PYRAMID_CELL x PYRAMID_CELL pixels, each level above halves the grid, up to
+// a single cell for the whole frame. Not safe to share between threads.
+
+#define PYRAMID_CELL 4
+
+typedef struct {
+   // only meaningful when pixels > 0
+   int minimum;
+   int maximum;
+   // pixels scoring maxIterations, i.e. taken to be in the set
+   long inSet;
+   // pixels summarised, fewer than the area while the frame is being filled in
+   long pixels;
+} scoreSummary;
+
+typedef struct scorePyramidData *ScorePyramid;
+
+// scores is a width x height grid, borrowed for the life of the pyramid
+ScorePyramid createScorePyramid(int **scores, int width, int height, int maxIterations);
+
+void freeScorePyramid(ScorePyramid pyramid);
+
+// forget everything indexed, e.g. once the frame shows a new view
+void ScorePyramid_clear(ScorePyramid pyramid);
+
+// fold in a rectangle of the grid whose scores are final
+// pixels already indexed since the last clear are skipped
+void ScorePyramid_addRegion(ScorePyramid pyramid, int left, int top, int width, int height);
+
+// snapshot the fractal's completed tiles not yet indexed into the grid (see
+// MandelbrotSet_snapshotTiles) and fold them in; the grid must be the fractal's size
+// clears first if the fractal's tiles were invalidated since the last call (see
+// MandelbrotSet_getEpoch), so a pyramid can follow one fractal across views
+// returns the number of tiles added
+int ScorePyramid_addCompletedTiles(ScorePyramid pyramid, MandelbrotSet fractal);
+
+// summarise the indexed pixels of a rectangle (clipped to the frame), visiting
+// O(log n) cells plus those along the rectangle's border
+// returns true if every pixel of the clipped rectangle has been indexed
+bool ScorePyramid_query(ScorePyramid pyramid, int left, int top, int width, int height, scoreSummary *summary);
+
+int ScorePyramid_getLevelCount(ScorePyramid pyramid);
+
+// a coarse view: the level's cells row by row, *across x *down of them
+// returns a borrowed reference (freed when the pyramid is freed), kept up to date as regions are added
+const scoreSummary *ScorePyramid_getLevel(ScorePyramid pyramid, int level, int *across, int *down);
+
+#endif
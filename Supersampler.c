@@ -0,0 +1,234 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "Supersampler.h"
+
+// output rows generated per band, larger bands waste less on Lanczos overlap
+#define BAND_ROWS 16
+
+// Lanczos reach in output pixels either side of a pixel's center
+#define LANCZOS_LOBES 2
+
+struct supersamplerData {
+   int width;
+   int height;
+   int factor;
+   int maxIterations;
+
+   mandelbrotCoord center;
+   real resolution;
+
+   float **values;
+
+   // one band of samples, reused for every band
+   MandelbrotSet band;
+   int bandRows;
+
+   // the band's samples filtered across but not yet down, one row per sample row
+   float **across;
+
+   // filter weights for one output pixel along either axis, applied to taps
+   // consecutive samples starting margin samples before the pixel's own
+   double *weights;
+   int taps;
+   int margin;
+};
+
+static void filterBand(Supersampler supersampler, int firstRow);
+
+static void computeWeights(Supersampler supersampler, supersampleFilter filter);
+static double lanczos(double distance);
+
+static float **createGrid(int width, int height);
+static void freeGrid(float **grid);
+
+
+Supersampler createSupersampler(int width, int height, int factor, supersampleFilter filter) {
+   assert(factor > 0);
+
+   Supersampler supersampler = malloc(sizeof (struct supersamplerData));
+   assert(supersampler != NULL);
+
+   supersampler->width = width;
+   supersampler->height = height;
+   supersampler->factor = factor;
+   supersampler->maxIterations = DEFAULT_MAX_ITERATIONS;
+   supersampler->center.x = 0;
+   supersampler->center.y = 0;
+   supersampler->resolution = 1;
+
+   supersampler->values = createGrid(width, height);
+
+   computeWeights(supersampler, filter);
+
+   supersampler->bandRows = (height < BAND_ROWS) ? height : BAND_ROWS;
+   supersampler->band = createMandelbrotSet(width * factor + 2 * supersampler->margin,
+                                            supersampler->bandRows * factor + 2 * supersampler->margin);
+   supersampler->across = createGrid(width, supersampler->bandRows * factor + 2 * supersampler->margin);
+
+   return supersampler;
+}
+
+void freeSupersampler(Supersampler supersampler) {
+   freeMandelbrotSet(supersampler->band);
+   freeGrid(supersampler->across);
+   freeGrid(supersampler->values);
+   free(supersampler->weights);
+   free(supersampler);
+}
+
+void Supersampler_setView(Supersampler supersampler, mandelbrotCoord center, real resolution) {
+   supersampler->center = center;
+   supersampler->resolution = resolution;
+}
+
+void Supersampler_setMaxIterations(Supersampler supersampler, int maxIterations) {
+   supersampler->maxIterations = maxIterations;
+}
+
+void Supersampler_render(Supersampler supersampler, bool isFast) {
+   int firstRow;
+   mandelbrotCoord bandCenter;
+   real sampleResolution = supersampler->resolution / supersampler->factor;
+   int bandHeight = supersampler->bandRows * supersampler->factor + 2 * supersampler->margin;
+
+   // top-left corner of the output in fractal coordinates
+   real left = supersampler->center.x - (supersampler->width  * supersampler->resolution)/2.0;
+   real top  = supersampler->center.y + (supersampler->height * supersampler->resolution)/2.0;
+
+   MandelbrotSet_setMaxIterations(supersampler->band, supersampler->maxIterations);
+
+   // every band is as wide as the output plus the margins, so only its height moves
+   bandCenter.x = left + (supersampler->width * supersampler->resolution)/2.0;
+
+   for (firstRow = 0; firstRow < supersampler->height; firstRow += supersampler->bandRows) {
+      // the band's first sample row lies margin samples above the band's first output row
+      bandCenter.y = top - (firstRow * supersampler->resolution)
+                         + (supersampler->margin * sampleResolution)
+                         - (bandHeight * sampleResolution)/2.0;
+      MandelbrotSet_setView(supersampler->band, bandCenter, sampleResolution);
+
+      if (isFast) {
+         MandelbrotSet_fastGenerate(supersampler->band);
+      } else {
+         MandelbrotSet_generate(supersampler->band);
+      }
+
+      filterBand(supersampler, firstRow);
+   }
+}
+
+float **Supersampler_getValues(Supersampler supersampler) {
+   return supersampler->values;
+}
+
+
+// Static functions
+
+static void filterBand(Supersampler supersampler, int firstRow) {
+   int row, col, tap, sampleRow;
+   int rows;
+   double sum;
+   int **samples = MandelbrotSet_getScores(supersampler->band);
+   int sampleRows = supersampler->bandRows * supersampler->factor + 2 * supersampler->margin;
+   int factor = supersampler->factor;
+   int taps = supersampler->taps;
+   const double *weights = supersampler->weights;
+
+   // the filter is separable: across each sample row first, then down each column
+   for (sampleRow = 0; sampleRow != sampleRows; ++sampleRow) {
+      for (col = 0; col != supersampler->width; ++col) {
+         sum = 0;
+         for (tap = 0; tap != taps; ++tap) {
+            sum += weights[tap] * samples[sampleRow][col * factor + tap];
+         }
+         supersampler->across[sampleRow][col] = (float)sum;
+      }
+   }
+
+   // the last band may hang off the bottom of the output
+   rows = (firstRow + supersampler->bandRows <= supersampler->height)
+          ? supersampler->bandRows : supersampler->height - firstRow;
+
+   for (row = 0; row != rows; ++row) {
+      for (col = 0; col != supersampler->width; ++col) {
+         sum = 0;
+         for (tap = 0; tap != taps; ++tap) {
+            sum += weights[tap] * supersampler->across[row * factor + tap][col];
+         }
+         if (sum < 0) {
+            sum = 0;
+         } else if (sum > supersampler->maxIterations) {
+            sum = supersampler->maxIterations;
+         }
+         supersampler->values[firstRow + row][col] = (float)sum;
+      }
+   }
+}
+
+static void computeWeights(Supersampler supersampler, supersampleFilter filter) {
+   int tap;
+   double distance, total = 0;
+   int factor = supersampler->factor;
+
+   if (filter == SUPERSAMPLE_LANCZOS) {
+      // samples whose centers are within reach of the output pixel's center
+      supersampler->margin = ((2 * LANCZOS_LOBES - 1) * factor + 1) / 2;
+   } else {
+      supersampler->margin = 0;
+   }
+   supersampler->taps = factor + 2 * supersampler->margin;
+
+   supersampler->weights = malloc(sizeof (double) * supersampler->taps);
+   assert(supersampler->weights != NULL);
+
+   for (tap = 0; tap != supersampler->taps; ++tap) {
+      if (filter == SUPERSAMPLE_LANCZOS) {
+         // from the output pixel's center to the sample's, in output pixels
+         distance = (tap - supersampler->margin + 0.5) / factor - 0.5;
+         supersampler->weights[tap] = lanczos(distance);
+      } else {
+         supersampler->weights[tap] = 1;
+      }
+      total += supersampler->weights[tap];
+   }
+
+   // normalised, so a flat region keeps its score
+   for (tap = 0; tap != supersampler->taps; ++tap) {
+      supersampler->weights[tap] /= total;
+   }
+}
+
+static double lanczos(double distance) {
+   double x = M_PI * distance;
+
+   if (distance == 0) {
+      return 1;
+   } else if (fabs(distance) >= LANCZOS_LOBES) {
+      return 0;
+   }
+
+   return LANCZOS_LOBES * sin(x) * sin(x / LANCZOS_LOBES) / (x * x);
+}
+
+static float **createGrid(int width, int height) {
+   int row;
+
+   float **grid = malloc(sizeof (float *) * height);
+   assert(grid != NULL);
+   grid[0] = malloc(sizeof (float) * width * height);
+   assert(grid[0] != NULL);
+   for (row = 1; row != height; ++row) {
+      grid[row] = grid[0] + (size_t)row * width;
+   }
+
+   return grid;
+}
+
+static void freeGrid(float **grid) {
+   free(grid[0]);
+   free(grid);
+}
@@ -0,0 +1,42 @@
+#ifndef SUPERSAMPLER_H
+#define SUPERSAMPLER_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+
+// Anti-aliased renders at print resolution without a supersampled image.
+//
+// Each output pixel is filtered from factor x factor samples, but the samples
+// are generated a band of output rows at a time, filtered down into the output
+// and discarded, so memory stays at the output plus one band whatever the factor.
+// Lanczos bands overlap their neighbours by the filter's reach, so they cost a
+// little more than box bands.
+
+typedef enum {
+   // the mean of the samples inside the output pixel
+   SUPERSAMPLE_BOX,
+   // Lanczos (a = 2) over samples up to two output pixels away, sharper than
+   // box; results are clamped to [0, maxIterations] against its negative lobes
+   SUPERSAMPLE_LANCZOS
+} supersampleFilter;
+
+typedef struct supersamplerData *Supersampler;
+
+Supersampler createSupersampler(int width, int height, int factor, supersampleFilter filter);
+
+void freeSupersampler(Supersampler supersampler);
+
+// as MandelbrotSet_setView, resolution is the distance between output pixel centers
+void Supersampler_setView(Supersampler supersampler, mandelbrotCoord center, real resolution);
+
+void Supersampler_setMaxIterations(Supersampler supersampler, int maxIterations);
+
+// generate every band, with fastGenerate when isFast
+void Supersampler_render(Supersampler supersampler, bool isFast);
+
+// returns a borrowed reference (freed when supersampler is freed)
+// filtered scores, rows stored back to back as for MandelbrotSet_getScores
+float **Supersampler_getValues(Supersampler supersampler);
+
+#endif
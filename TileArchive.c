@@ -0,0 +1,392 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+#include "TileArchive.h"
+
+#define INITIAL_INDEX_CAPACITY 64
+
+// the index starts on a multiple of this, so entries can be read in place
+#define INDEX_ALIGNMENT 8
+
+struct tileArchiveWriterData {
+   FILE *file;
+   int tileSize;
+   int maxIterations;
+   bool hasFailed;
+
+   tileArchiveEntry *index;
+   uint32_t tileCount;
+   uint32_t indexCapacity;
+
+   // payload offset of the next tile
+   uint64_t offset;
+
+   // reused encoding buffer
+   unsigned char *buffer;
+   size_t bufferCapacity;
+};
+
+struct tileArchiveData {
+   int fd;
+   unsigned char *mapping;
+   size_t mappingSize;
+
+   const tileArchiveHeader *header;
+   const tileArchiveEntry *index;
+};
+
+static int compareEntries(const void *a, const void *b);
+
+// every payload lies between the header and the index, and keys strictly increase
+static bool isIndexValid(const tileArchiveEntry *index, uint32_t tileCount, uint64_t indexOffset);
+
+// little-endian base 128 varints, at most 5 bytes for a 32 bit value
+static inline size_t putVarint(unsigned char *out, uint32_t value);
+static inline bool getVarint(const unsigned char **in, const unsigned char *end, uint32_t *value);
+
+
+TileArchiveWriter createTileArchiveWriter(const char *path, int tileSize, int maxIterations) {
+   tileArchiveHeader header = { 0 };
+
+   TileArchiveWriter writer = malloc(sizeof (struct tileArchiveWriterData));
+   assert(writer != NULL);
+
+   writer->file = fopen(path, "wb");
+   if (writer->file == NULL) {
+      free(writer);
+      return NULL;
+   }
+
+   writer->tileSize = tileSize;
+   writer->maxIterations = maxIterations;
+   writer->hasFailed = false;
+
+   writer->tileCount = 0;
+   writer->indexCapacity = INITIAL_INDEX_CAPACITY;
+   writer->index = malloc(sizeof (tileArchiveEntry) * writer->indexCapacity);
+   assert(writer->index != NULL);
+
+   writer->buffer = NULL;
+   writer->bufferCapacity = 0;
+
+   // reserve space for the header, it is filled in on close
+   if (fwrite(&header, sizeof header, 1, writer->file) != 1) {
+      writer->hasFailed = true;
+   }
+   writer->offset = sizeof header;
+
+   return writer;
+}
+
+void TileArchiveWriter_addTile(TileArchiveWriter writer, tileKey key, int **scores) {
+   tileArchiveEntry *entry;
+   size_t length = TileArchive_encodeScores(scores, writer->tileSize, &writer->buffer, &writer->bufferCapacity);
+
+   if (writer->tileCount == writer->indexCapacity) {
+      writer->indexCapacity *= 2;
+      writer->index = realloc(writer->index, sizeof (tileArchiveEntry) * writer->indexCapacity);
+      assert(writer->index != NULL);
+   }
+
+   entry = &writer->index[writer->tileCount];
+   entry->z = key.z;
+   entry->x = key.x;
+   entry->y = key.y;
+   entry->length = (uint32_t)length;
+   entry->offset = writer->offset;
+
+   if (fwrite(writer->buffer, 1, length, writer->file) != length) {
+      writer->hasFailed = true;
+   }
+
+   writer->offset += length;
+   writer->tileCount++;
+}
+
+bool closeTileArchiveWriter(TileArchiveWriter writer) {
+   tileArchiveHeader header;
+   bool isWritten;
+   static const unsigned char padding[INDEX_ALIGNMENT] = { 0 };
+   size_t paddingLength = (INDEX_ALIGNMENT - writer->offset % INDEX_ALIGNMENT) % INDEX_ALIGNMENT;
+
+   qsort(writer->index, writer->tileCount, sizeof (tileArchiveEntry), compareEntries);
+
+   if (fwrite(padding, 1, paddingLength, writer->file) != paddingLength) {
+      writer->hasFailed = true;
+   }
+   writer->offset += paddingLength;
+
+   header.magic = TILE_ARCHIVE_MAGIC;
+   header.version = TILE_ARCHIVE_VERSION;
+   header.tileSize = (uint32_t)writer->tileSize;
+   header.tileCount = writer->tileCount;
+   header.maxIterations = (uint32_t)writer->maxIterations;
+   header.reserved = 0;
+   header.indexOffset = writer->offset;
+
+   if (fwrite(writer->index, sizeof (tileArchiveEntry), writer->tileCount, writer->file) != writer->tileCount) {
+      writer->hasFailed = true;
+   }
+
+   if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof header, 1, writer->file) != 1) {
+      writer->hasFailed = true;
+   }
+
+   if (fclose(writer->file) != 0) {
+      writer->hasFailed = true;
+   }
+
+   isWritten = !writer->hasFailed;
+
+   free(writer->buffer);
+   free(writer->index);
+   free(writer);
+
+   return isWritten;
+}
+
+
+TileArchive openTileArchive(const char *path) {
+   struct stat info;
+   const tileArchiveHeader *header;
+   uint64_t indexSize;
+
+   int fd = open(path, O_RDONLY);
+   if (fd < 0) {
+      return NULL;
+   }
+
+   if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof (tileArchiveHeader)) {
+      close(fd);
+      return NULL;
+   }
+
+   void *mapping = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   if (mapping == MAP_FAILED) {
+      close(fd);
+      return NULL;
+   }
+
+   // validate the header before trusting the index, without letting the sum overflow
+   header = mapping;
+   indexSize = (uint64_t)header->tileCount * sizeof (tileArchiveEntry);
+   if (header->magic != TILE_ARCHIVE_MAGIC || header->version != TILE_ARCHIVE_VERSION ||
+       header->tileSize == 0 ||
+       header->indexOffset < sizeof (tileArchiveHeader) ||
+       header->indexOffset % INDEX_ALIGNMENT != 0 ||
+       header->indexOffset > (uint64_t)info.st_size ||
+       indexSize != (uint64_t)info.st_size - header->indexOffset) {
+      munmap(mapping, info.st_size);
+      close(fd);
+      return NULL;
+   }
+
+   TileArchive archive = malloc(sizeof (struct tileArchiveData));
+   assert(archive != NULL);
+
+   archive->fd = fd;
+   archive->mapping = mapping;
+   archive->mappingSize = info.st_size;
+   archive->header = header;
+   archive->index = (const tileArchiveEntry *)(archive->mapping + header->indexOffset);
+
+   if (!isIndexValid(archive->index, header->tileCount, header->indexOffset)) {
+      closeTileArchive(archive);
+      return NULL;
+   }
+
+   // the index is read by binary search, hint the kernel to keep it resident
+   madvise(archive->mapping, archive->mappingSize, MADV_RANDOM);
+
+   return archive;
+}
+
+void closeTileArchive(TileArchive archive) {
+   munmap(archive->mapping, archive->mappingSize);
+   close(archive->fd);
+   free(archive);
+}
+
+int TileArchive_getTileSize(TileArchive archive) {
+   return archive->header->tileSize;
+}
+
+int TileArchive_getMaxIterations(TileArchive archive) {
+   return archive->header->maxIterations;
+}
+
+const tileArchiveEntry *TileArchive_find(TileArchive archive, tileKey key) {
+   tileArchiveEntry wanted = { key.z, key.x, key.y, 0, 0 };
+
+   return bsearch(&wanted, archive->index, archive->header->tileCount,
+                  sizeof (tileArchiveEntry), compareEntries);
+}
+
+const unsigned char *TileArchive_getPayload(TileArchive archive, const tileArchiveEntry *entry) {
+   return archive->mapping + entry->offset;
+}
+
+bool TileArchive_readTile(TileArchive archive, tileKey key, int **scores) {
+   const tileArchiveEntry *entry = TileArchive_find(archive, key);
+   bool isRead = false;
+
+   if (entry != NULL) {
+      isRead = TileArchive_decodeScores(TileArchive_getPayload(archive, entry), entry->length,
+                                        scores, archive->header->tileSize);
+   }
+
+   return isRead;
+}
+
+ssize_t TileArchive_sendTile(TileArchive archive, const tileArchiveEntry *entry, int outFd) {
+   off_t offset = entry->offset;
+   size_t remaining = entry->length;
+   ssize_t sent;
+
+   // the kernel copies from the page cache to the socket, nothing passes through user space
+   while (remaining > 0) {
+      sent = sendfile(outFd, archive->fd, &offset, remaining);
+      if (sent < 0 && errno == EINTR) {
+         continue;
+      } else if (sent <= 0) {
+         return -1;
+      }
+      remaining -= sent;
+   }
+
+   return entry->length;
+}
+
+
+size_t TileArchive_encodeScores(int **scores, int size, unsigned char **buffer, size_t *capacity) {
+   int row, col;
+   int runScore;
+   uint32_t runLength;
+   size_t length = 0;
+
+   // worst case is a run per pixel, each a 5 byte length and 5 byte score
+   size_t worstCase = (size_t)size * size * 10;
+   if (*capacity < worstCase) {
+      *buffer = realloc(*buffer, worstCase);
+      assert(*buffer != NULL);
+      *capacity = worstCase;
+   }
+
+   // runs continue across row ends, interior and far exterior tiles become a single run
+   runScore = scores[0][0];
+   runLength = 0;
+   for (row = 0; row != size; ++row) {
+      for (col = 0; col != size; ++col) {
+         if (scores[row][col] != runScore) {
+            length += putVarint(*buffer + length, runLength);
+            length += putVarint(*buffer + length, (uint32_t)runScore);
+            runScore = scores[row][col];
+            runLength = 0;
+         }
+         runLength++;
+      }
+   }
+   length += putVarint(*buffer + length, runLength);
+   length += putVarint(*buffer + length, (uint32_t)runScore);
+
+   return length;
+}
+
+bool TileArchive_decodeScores(const unsigned char *payload, size_t length, int **scores, int size) {
+   const unsigned char *end = payload + length;
+   uint32_t runLength, runScore;
+   int row = 0;
+   int col = 0;
+
+   while (payload != end) {
+      if (!getVarint(&payload, end, &runLength) || !getVarint(&payload, end, &runScore)) {
+         return false;
+      }
+
+      while (runLength > 0) {
+         if (row == size) {
+            return false;
+         }
+         scores[row][col] = (int)runScore;
+         runLength--;
+
+         col++;
+         if (col == size) {
+            col = 0;
+            row++;
+         }
+      }
+   }
+
+   return row == size && col == 0;
+}
+
+
+// Static functions
+
+static int compareEntries(const void *a, const void *b) {
+   const tileArchiveEntry *entryA = a;
+   const tileArchiveEntry *entryB = b;
+   tileKey keyA = { entryA->z, entryA->x, entryA->y };
+   tileKey keyB = { entryB->z, entryB->x, entryB->y };
+
+   return TilePyramid_compareKeys(&keyA, &keyB);
+}
+
+static bool isIndexValid(const tileArchiveEntry *index, uint32_t tileCount, uint64_t indexOffset) {
+   uint32_t entry;
+
+   for (entry = 0; entry != tileCount; ++entry) {
+      if (index[entry].offset < sizeof (tileArchiveHeader) ||
+          index[entry].length > indexOffset ||
+          index[entry].offset > indexOffset - index[entry].length) {
+         return false;
+      }
+
+      // bsearch needs them sorted, and duplicates would make lookups ambiguous
+      if (entry > 0 && compareEntries(&index[entry - 1], &index[entry]) >= 0) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static inline size_t putVarint(unsigned char *out, uint32_t value) {
+   size_t length = 0;
+
+   while (value >= 0x80) {
+      out[length++] = (unsigned char)(value | 0x80);
+      value >>= 7;
+   }
+   out[length++] = (unsigned char)value;
+
+   return length;
+}
+
+static inline bool getVarint(const unsigned char **in, const unsigned char *end, uint32_t *value) {
+   const unsigned char *position = *in;
+   uint32_t result = 0;
+   int shift = 0;
+
+   while (position != end && shift < 35) {
+      result |= (uint32_t)(*position & 0x7f) << shift;
+      if ((*position++ & 0x80) == 0) {
+         *in = position;
+         *value = result;
+         return true;
+      }
+      shift += 7;
+   }
+
+   return false;
+}
@@ -0,0 +1,92 @@
+#ifndef TILE_ARCHIVE_H
+#define TILE_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "TilePyramid.h"
+
+// Packed tile archive, one file for a whole pyramid:
+//
+//    header   | magic, version, tile size, tile count, maxIterations, index offset
+//    payloads | run-length encoded tile scores, back to back, zero padded to 8 bytes
+//    index    | (z, x, y, length, offset) entries sorted by key
+//
+// all fields are fixed width in host byte order
+
+#define TILE_ARCHIVE_MAGIC   0x4154424d  // "MBTA"
+#define TILE_ARCHIVE_VERSION 2
+
+typedef struct {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t tileSize;
+   uint32_t tileCount;
+   // the limit every tile was rendered with, tiles of another limit don't match them
+   uint32_t maxIterations;
+   uint32_t reserved;
+   uint64_t indexOffset;
+} tileArchiveHeader;
+
+typedef struct {
+   uint32_t z;
+   uint32_t x;
+   uint32_t y;
+   uint32_t length;
+   uint64_t offset;
+} tileArchiveEntry;
+
+typedef struct tileArchiveWriterData *TileArchiveWriter;
+typedef struct tileArchiveData *TileArchive;
+
+// writing
+
+// returns NULL if the file could not be created
+// every tile added must have been rendered with maxIterations
+TileArchiveWriter createTileArchiveWriter(const char *path, int tileSize, int maxIterations);
+
+// scores is a tileSize x tileSize grid as returned by MandelbrotSet_getScores
+void TileArchiveWriter_addTile(TileArchiveWriter writer, tileKey key, int **scores);
+
+// writes the sorted index and header, then frees the writer
+// returns false if any write failed
+bool closeTileArchiveWriter(TileArchiveWriter writer);
+
+// reading
+
+// maps the archive into memory, returns NULL if it is missing, of another version
+// or malformed (an index misaligned or running off the file, or entries unsorted
+// or outside the payloads)
+TileArchive openTileArchive(const char *path);
+
+void closeTileArchive(TileArchive archive);
+
+int TileArchive_getTileSize(TileArchive archive);
+
+int TileArchive_getMaxIterations(TileArchive archive);
+
+// O(log n) lookup in the mapped index, returns NULL if the tile is absent
+const tileArchiveEntry *TileArchive_find(TileArchive archive, tileKey key);
+
+// returns a borrowed pointer into the mapping (valid until the archive is closed)
+const unsigned char *TileArchive_getPayload(TileArchive archive, const tileArchiveEntry *entry);
+
+// decode a tile's scores into a tileSize x tileSize grid
+bool TileArchive_readTile(TileArchive archive, tileKey key, int **scores);
+
+// copy a tile's encoded payload straight from the archive to a socket or file
+// returns the number of bytes sent, or -1 on error
+ssize_t TileArchive_sendTile(TileArchive archive, const tileArchiveEntry *entry, int outFd);
+
+// payload encoding, shared with anything that produces or consumes tiles
+
+// run-length encode a size x size grid, growing *buffer as needed
+// returns the encoded length
+size_t TileArchive_encodeScores(int **scores, int size, unsigned char **buffer, size_t *capacity);
+
+// returns false if the payload does not decode to exactly size x size scores
+bool TileArchive_decodeScores(const unsigned char *payload, size_t length, int **scores, int size);
+
+#endif
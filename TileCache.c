@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "TileCache.h"
+
+typedef struct cachedTile {
+   tileKey key;
+   unsigned char *payload;
+   size_t length;
+
+   // hash chain
+   struct cachedTile *nextInBucket;
+   // recency list, most recently used at the head
+   struct cachedTile *newer;
+   struct cachedTile *older;
+} cachedTile;
+
+struct tileCacheData {
+   int capacity;
+   int count;
+
+   cachedTile **buckets;
+   int bucketCount;
+
+   cachedTile *newest;
+   cachedTile *oldest;
+
+   pthread_mutex_t lock;
+};
+
+static cachedTile **findSlot(TileCache cache, tileKey key);
+static void unlinkRecency(TileCache cache, cachedTile *tile);
+static void linkNewest(TileCache cache, cachedTile *tile);
+static void evictOldest(TileCache cache);
+static unsigned int hashKey(tileKey key);
+
+
+TileCache createTileCache(int capacity) {
+   assert(capacity > 0);
+
+   TileCache cache = malloc(sizeof (struct tileCacheData));
+   assert(cache != NULL);
+
+   cache->capacity = capacity;
+   cache->count = 0;
+
+   // at most half full, so chains stay short
+   cache->bucketCount = capacity * 2;
+   cache->buckets = calloc(cache->bucketCount, sizeof (cachedTile *));
+   assert(cache->buckets != NULL);
+
+   cache->newest = NULL;
+   cache->oldest = NULL;
+
+   pthread_mutex_init(&cache->lock, NULL);
+
+   return cache;
+}
+
+void freeTileCache(TileCache cache) {
+   cachedTile *tile, *older;
+
+   for (tile = cache->newest; tile != NULL; tile = older) {
+      older = tile->older;
+      free(tile->payload);
+      free(tile);
+   }
+
+   pthread_mutex_destroy(&cache->lock);
+   free(cache->buckets);
+   free(cache);
+}
+
+bool TileCache_get(TileCache cache, tileKey key, unsigned char **buffer, size_t *capacity, size_t *length) {
+   cachedTile *tile;
+
+   pthread_mutex_lock(&cache->lock);
+
+   tile = *findSlot(cache, key);
+   if (tile != NULL) {
+      unlinkRecency(cache, tile);
+      linkNewest(cache, tile);
+
+      if (tile->length > *capacity) {
+         *buffer = realloc(*buffer, tile->length);
+         assert(*buffer != NULL);
+         *capacity = tile->length;
+      }
+      memcpy(*buffer, tile->payload, tile->length);
+      *length = tile->length;
+   }
+
+   pthread_mutex_unlock(&cache->lock);
+
+   return tile != NULL;
+}
+
+bool TileCache_contains(TileCache cache, tileKey key) {
+   bool isCached;
+
+   pthread_mutex_lock(&cache->lock);
+   isCached = (*findSlot(cache, key) != NULL);
+   pthread_mutex_unlock(&cache->lock);
+
+   return isCached;
+}
+
+void TileCache_put(TileCache cache, tileKey key, const unsigned char *payload, size_t length) {
+   cachedTile **slot;
+   cachedTile *tile;
+
+   // copy outside the lock
+   unsigned char *copy = malloc(length > 0 ? length : 1);
+   assert(copy != NULL);
+   memcpy(copy, payload, length);
+
+   pthread_mutex_lock(&cache->lock);
+
+   slot = findSlot(cache, key);
+   tile = *slot;
+   if (tile != NULL) {
+      free(tile->payload);
+      unlinkRecency(cache, tile);
+   } else {
+      if (cache->count == cache->capacity) {
+         evictOldest(cache);
+         // eviction may have unlinked the slot's predecessor
+         slot = findSlot(cache, key);
+      }
+
+      tile = malloc(sizeof (cachedTile));
+      assert(tile != NULL);
+      tile->key = key;
+      tile->nextInBucket = NULL;
+      *slot = tile;
+      cache->count++;
+   }
+
+   tile->payload = copy;
+   tile->length = length;
+   linkNewest(cache, tile);
+
+   pthread_mutex_unlock(&cache->lock);
+}
+
+
+// Static functions
+
+// the chain link that points (or would point) at key's entry
+static cachedTile **findSlot(TileCache cache, tileKey key) {
+   cachedTile **slot = &cache->buckets[hashKey(key) % cache->bucketCount];
+
+   while (*slot != NULL && TilePyramid_compareKeys(&(*slot)->key, &key) != 0) {
+      slot = &(*slot)->nextInBucket;
+   }
+
+   return slot;
+}
+
+static void unlinkRecency(TileCache cache, cachedTile *tile) {
+   if (tile->newer != NULL) {
+      tile->newer->older = tile->older;
+   } else {
+      cache->newest = tile->older;
+   }
+   if (tile->older != NULL) {
+      tile->older->newer = tile->newer;
+   } else {
+      cache->oldest = tile->newer;
+   }
+}
+
+static void linkNewest(TileCache cache, cachedTile *tile) {
+   tile->newer = NULL;
+   tile->older = cache->newest;
+   if (cache->newest != NULL) {
+      cache->newest->newer = tile;
+   } else {
+      cache->oldest = tile;
+   }
+   cache->newest = tile;
+}
+
+static void evictOldest(TileCache cache) {
+   cachedTile *tile = cache->oldest;
+   cachedTile **slot = findSlot(cache, tile->key);
+
+   *slot = tile->nextInBucket;
+   unlinkRecency(cache, tile);
+   cache->count--;
+
+   free(tile->payload);
+   free(tile);
+}
+
+static unsigned int hashKey(tileKey key) {
+   // mix the three coordinates, neighbouring tiles land in different buckets
+   unsigned int hash = key.z * 0x9e3779b1u;
+   hash = (hash ^ key.x) * 0x85ebca6bu;
+   hash = (hash ^ key.y) * 0xc2b2ae35u;
+
+   return hash ^ (hash >> 16);
+}
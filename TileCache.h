@@ -0,0 +1,29 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "TilePyramid.h"
+
+// Encoded tiles (TileArchive_encodeScores payloads) rendered on demand, kept
+// in memory up to a fixed count and evicted least recently used first.
+// Safe to share between threads.
+
+typedef struct tileCacheData *TileCache;
+
+TileCache createTileCache(int capacity);
+
+void freeTileCache(TileCache cache);
+
+// copy a cached payload into *buffer (grown as needed, as for TileArchive_encodeScores)
+// returns false, leaving the buffer alone, if the tile isn't cached
+bool TileCache_get(TileCache cache, tileKey key, unsigned char **buffer, size_t *capacity, size_t *length);
+
+// doesn't count as a use, so probing for prefetch doesn't keep tiles alive
+bool TileCache_contains(TileCache cache, tileKey key);
+
+// store a copy of a payload, replacing any already cached for the key
+void TileCache_put(TileCache cache, tileKey key, const unsigned char *payload, size_t length);
+
+#endif
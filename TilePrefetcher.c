@@ -0,0 +1,428 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "TilePrefetcher.h"
+#include "TileArchive.h"
+
+// viewport updates remembered for the velocity estimate
+#define HISTORY_LENGTH 4
+
+// updates further apart than this don't describe current motion
+#define HISTORY_SECONDS 1.0
+
+// how far ahead to predict; the viewport now is left to the client's own requests
+static const double lookaheadSeconds[] = { 0.25, 0.5, 1.0 };
+#define LOOKAHEAD_COUNT (int)(sizeof lookaheadSeconds / sizeof lookaheadSeconds[0])
+
+// most tiles wanted by one prediction, and queued or rendering at once
+#define MAX_PREFETCH 64
+
+// a prefetch renders this long before checking for visible work to yield to
+#define PREFETCH_SLICE_MICROSECONDS 2000
+
+typedef struct prefetchJob prefetchJob;
+
+struct tilePrefetcherData {
+   TileCache cache;
+   MandelbrotPool pool;
+   int maxIterations;
+   int maxLevel;
+
+   // guards everything below
+   pthread_mutex_t lock;
+   pthread_cond_t hasFinished;
+
+   // the owner's reference plus one per job, the last to let go frees the prefetcher
+   int references;
+
+   // recent viewports and when they arrived (seconds), oldest first
+   tileViewport history[HISTORY_LENGTH];
+   double historyTimes[HISTORY_LENGTH];
+   int historyCount;
+
+   // what the latest prediction wants, a prefetch for any other tile is dropped
+   tileKey wanted[MAX_PREFETCH];
+   int wantedCount;
+
+   // jobs queued or rendering
+   prefetchJob *pending[MAX_PREFETCH];
+   int pendingCount;
+
+   bool isClosing;
+   int renderCount;
+};
+
+struct prefetchJob {
+   TilePrefetcher prefetcher;
+   tileKey key;
+   // created on the first slice, then carries the time-sliced render between slices
+   MandelbrotSet fractal;
+
+   // set under the prefetcher's lock: a slice is running on a pool thread (not
+   // queued, first or after yielding), the owner is waiting for the tile, or the
+   // owner took the tile over while it was queued
+   bool isRunning;
+   bool isAwaited;
+   bool isDropped;
+};
+
+static void runPrefetch(void *data);
+
+// true if the job should stop: closing, dropped, or no longer predicted and not awaited
+// marks the job running otherwise
+static bool isStale(prefetchJob *job);
+
+// true, marking the job no longer running, if it may go back to the background
+// queue; an awaited job keeps its thread
+static bool yieldJob(prefetchJob *job);
+static void finishJob(prefetchJob *job, bool isRendered);
+
+static prefetchJob *findPending(TilePrefetcher prefetcher, tileKey key);
+static void destroyPrefetcher(TilePrefetcher prefetcher);
+
+// add the tiles covering a viewport to the wanted list
+static void addWantedTiles(TilePrefetcher prefetcher, real zoom, mandelbrotCoord center, int width, int height);
+
+static bool containsKey(const tileKey *keys, int count, tileKey key);
+static double secondsNow(void);
+
+
+TilePrefetcher createTilePrefetcher(TileCache cache, MandelbrotPool pool, int maxIterations, int maxLevel) {
+   TilePrefetcher prefetcher = malloc(sizeof (struct tilePrefetcherData));
+   assert(prefetcher != NULL);
+
+   prefetcher->cache = cache;
+   prefetcher->pool = pool;
+   prefetcher->maxIterations = maxIterations;
+   prefetcher->maxLevel = maxLevel;
+
+   pthread_mutex_init(&prefetcher->lock, NULL);
+   pthread_cond_init(&prefetcher->hasFinished, NULL);
+   prefetcher->references = 1;
+
+   prefetcher->historyCount = 0;
+   prefetcher->wantedCount = 0;
+   prefetcher->pendingCount = 0;
+   prefetcher->isClosing = false;
+   prefetcher->renderCount = 0;
+
+   return prefetcher;
+}
+
+void freeTilePrefetcher(TilePrefetcher prefetcher) {
+   bool isLast;
+
+   // queued jobs still run, but only to see they are stale and let go, so rather
+   // than wait behind other clients' work for that the last of them frees it
+   pthread_mutex_lock(&prefetcher->lock);
+   prefetcher->isClosing = true;
+   isLast = --prefetcher->references == 0;
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   if (isLast) {
+      destroyPrefetcher(prefetcher);
+   }
+}
+
+void TilePrefetcher_updateViewport(TilePrefetcher prefetcher, const tileViewport *viewport) {
+   int index, horizon;
+   double now = secondsNow();
+   double elapsed, ahead;
+   real zoomVelocity = 0;
+   mandelbrotCoord velocity = { 0, 0 };
+   mandelbrotCoord center;
+   real zoom;
+   const tileViewport *oldest;
+   prefetchJob *job;
+
+   pthread_mutex_lock(&prefetcher->lock);
+
+   // forget updates too old to say how the client is moving now
+   while (prefetcher->historyCount > 0 &&
+          (prefetcher->historyCount == HISTORY_LENGTH ||
+           now - prefetcher->historyTimes[0] > HISTORY_SECONDS)) {
+      for (index = 1; index != prefetcher->historyCount; ++index) {
+         prefetcher->history[index - 1] = prefetcher->history[index];
+         prefetcher->historyTimes[index - 1] = prefetcher->historyTimes[index];
+      }
+      prefetcher->historyCount--;
+   }
+   prefetcher->history[prefetcher->historyCount] = *viewport;
+   prefetcher->historyTimes[prefetcher->historyCount] = now;
+   prefetcher->historyCount++;
+
+   // average velocity over the remembered updates, in fractal units and levels per second
+   elapsed = now - prefetcher->historyTimes[0];
+   if (elapsed > 0) {
+      oldest = &prefetcher->history[0];
+      velocity.x = (viewport->center.x - oldest->center.x) / elapsed;
+      velocity.y = (viewport->center.y - oldest->center.y) / elapsed;
+      zoomVelocity = (viewport->zoom - oldest->zoom) / elapsed;
+   }
+
+   prefetcher->wantedCount = 0;
+   if (velocity.x != 0 || velocity.y != 0 || zoomVelocity != 0) {
+      // nearest predictions first, they are needed soonest
+      for (horizon = 0; horizon != LOOKAHEAD_COUNT; ++horizon) {
+         ahead = lookaheadSeconds[horizon];
+         center.x = viewport->center.x + velocity.x * ahead;
+         center.y = viewport->center.y + velocity.y * ahead;
+         zoom = viewport->zoom + zoomVelocity * ahead;
+         addWantedTiles(prefetcher, zoom, center, viewport->width, viewport->height);
+      }
+   }
+
+   for (index = 0; index != prefetcher->wantedCount && prefetcher->pendingCount != MAX_PREFETCH; ++index) {
+      if (findPending(prefetcher, prefetcher->wanted[index]) != NULL ||
+          TileCache_contains(prefetcher->cache, prefetcher->wanted[index])) {
+         continue;
+      }
+
+      job = malloc(sizeof (prefetchJob));
+      assert(job != NULL);
+      job->prefetcher = prefetcher;
+      job->key = prefetcher->wanted[index];
+      job->fractal = NULL;
+      job->isRunning = false;
+      job->isAwaited = false;
+      job->isDropped = false;
+
+      prefetcher->pending[prefetcher->pendingCount++] = job;
+      prefetcher->references++;
+      MandelbrotPool_submitBackground(prefetcher->pool, runPrefetch, job);
+   }
+
+   pthread_mutex_unlock(&prefetcher->lock);
+}
+
+bool TilePrefetcher_awaitTile(TilePrefetcher prefetcher, tileKey key) {
+   prefetchJob *job;
+   bool isAwaited = false;
+
+   pthread_mutex_lock(&prefetcher->lock);
+
+   job = findPending(prefetcher, key);
+   if (job != NULL && !job->isRunning) {
+      // queued behind other work, not yet started or yielded to it: background
+      // tasks only run once no ordinary task waits, so under steady load the
+      // caller's ordinary task gets it sooner
+      job->isDropped = true;
+   } else if (job != NULL && !job->isDropped) {
+      job->isAwaited = true;
+      isAwaited = true;
+      while (findPending(prefetcher, key) == job) {
+         pthread_cond_wait(&prefetcher->hasFinished, &prefetcher->lock);
+      }
+   }
+
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   return isAwaited;
+}
+
+int TilePrefetcher_getRenderCount(TilePrefetcher prefetcher) {
+   int renderCount;
+
+   pthread_mutex_lock(&prefetcher->lock);
+   renderCount = prefetcher->renderCount;
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   return renderCount;
+}
+
+
+// Static functions
+
+static void runPrefetch(void *data) {
+   prefetchJob *job = data;
+   TilePrefetcher prefetcher = job->prefetcher;
+   unsigned char *payload = NULL;
+   size_t capacity = 0;
+   size_t length;
+   bool isDone = false;
+
+   if (isStale(job)) {
+      finishJob(job, false);
+      return;
+   }
+
+   if (job->fractal == NULL) {
+      job->fractal = createMandelbrotSet(TILE_SIZE, TILE_SIZE);
+      MandelbrotSet_setMaxIterations(job->fractal, prefetcher->maxIterations);
+      MandelbrotSet_setPosition(job->fractal, TilePyramid_tileCenter(job->key), TilePyramid_tileZoom(job->key));
+      MandelbrotSet_beginSteps(job->fractal, true);
+   }
+
+   while (!isDone) {
+      isDone = MandelbrotSet_step(job->fractal, 0, PREFETCH_SLICE_MICROSECONDS);
+
+      // a tile a request is waiting on is visible work itself
+      if (!isDone && MandelbrotPool_hasWaitingWork(prefetcher->pool) && yieldJob(job)) {
+         // visible tiles are waiting, continue behind them
+         MandelbrotPool_submitBackground(prefetcher->pool, runPrefetch, job);
+         return;
+      }
+      if (!isDone && isStale(job)) {
+         finishJob(job, false);
+         return;
+      }
+   }
+
+   length = TileArchive_encodeScores(MandelbrotSet_getScores(job->fractal), TILE_SIZE, &payload, &capacity);
+
+   // under the lock, so once freeTilePrefetcher returns the cache is never touched
+   pthread_mutex_lock(&prefetcher->lock);
+   if (!prefetcher->isClosing) {
+      TileCache_put(prefetcher->cache, job->key, payload, length);
+   }
+   pthread_mutex_unlock(&prefetcher->lock);
+   free(payload);
+
+   finishJob(job, true);
+}
+
+static bool isStale(prefetchJob *job) {
+   TilePrefetcher prefetcher = job->prefetcher;
+   bool isStale;
+
+   pthread_mutex_lock(&prefetcher->lock);
+   isStale = prefetcher->isClosing || job->isDropped ||
+             (!job->isAwaited && !containsKey(prefetcher->wanted, prefetcher->wantedCount, job->key));
+   if (!isStale) {
+      job->isRunning = true;
+   }
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   return isStale;
+}
+
+static bool yieldJob(prefetchJob *job) {
+   TilePrefetcher prefetcher = job->prefetcher;
+   bool isYielded;
+
+   // one decision under the lock, so awaitTile sees the job either still running
+   // (and waits for it) or queued (and drops it), never in between
+   pthread_mutex_lock(&prefetcher->lock);
+   isYielded = !job->isAwaited;
+   if (isYielded) {
+      job->isRunning = false;
+   }
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   return isYielded;
+}
+
+static void finishJob(prefetchJob *job, bool isRendered) {
+   TilePrefetcher prefetcher = job->prefetcher;
+   int index;
+   bool isLast;
+
+   if (job->fractal != NULL) {
+      freeMandelbrotSet(job->fractal);
+   }
+
+   pthread_mutex_lock(&prefetcher->lock);
+   for (index = 0; index != prefetcher->pendingCount; ++index) {
+      if (prefetcher->pending[index] == job) {
+         // order doesn't matter, fill the gap with the last job
+         prefetcher->pending[index] = prefetcher->pending[--prefetcher->pendingCount];
+         break;
+      }
+   }
+   if (isRendered) {
+      prefetcher->renderCount++;
+   }
+   if (job->isAwaited) {
+      pthread_cond_broadcast(&prefetcher->hasFinished);
+   }
+   isLast = --prefetcher->references == 0;
+   pthread_mutex_unlock(&prefetcher->lock);
+
+   free(job);
+
+   if (isLast) {
+      destroyPrefetcher(prefetcher);
+   }
+}
+
+static prefetchJob *findPending(TilePrefetcher prefetcher, tileKey key) {
+   int index;
+
+   for (index = 0; index != prefetcher->pendingCount; ++index) {
+      if (TilePyramid_compareKeys(&prefetcher->pending[index]->key, &key) == 0) {
+         return prefetcher->pending[index];
+      }
+   }
+
+   return NULL;
+}
+
+static void destroyPrefetcher(TilePrefetcher prefetcher) {
+   pthread_cond_destroy(&prefetcher->hasFinished);
+   pthread_mutex_destroy(&prefetcher->lock);
+   free(prefetcher);
+}
+
+static void addWantedTiles(TilePrefetcher prefetcher, real zoom, mandelbrotCoord center, int width, int height) {
+   int level;
+   long long firstX, lastX, firstY, lastY, x, y, tilesAcross;
+   real tileWidth, pixelSize, halfWidth, halfHeight;
+   tileKey key;
+
+   if (zoom < 0) {
+      zoom = 0;
+   }
+   level = (zoom < prefetcher->maxLevel) ? (int)floorl(zoom) : prefetcher->maxLevel;
+
+   // the screen shows level tiles magnified by 2^(zoom - level)
+   tilesAcross = 1LL << level;
+   tileWidth = TILE_PLANE_SIZE / tilesAcross;
+   pixelSize = tileWidth / TILE_SIZE / powl(2, zoom - level);
+   halfWidth = width * pixelSize / 2;
+   halfHeight = height * pixelSize / 2;
+
+   firstX = (long long)floorl((center.x - halfWidth - TILE_PLANE_LEFT) / tileWidth);
+   lastX  = (long long)floorl((center.x + halfWidth - TILE_PLANE_LEFT) / tileWidth);
+   firstY = (long long)floorl((TILE_PLANE_TOP - (center.y + halfHeight)) / tileWidth);
+   lastY  = (long long)floorl((TILE_PLANE_TOP - (center.y - halfHeight)) / tileWidth);
+
+   firstX = (firstX < 0) ? 0 : firstX;
+   firstY = (firstY < 0) ? 0 : firstY;
+   lastX = (lastX >= tilesAcross) ? tilesAcross - 1 : lastX;
+   lastY = (lastY >= tilesAcross) ? tilesAcross - 1 : lastY;
+
+   key.z = level;
+   for (y = firstY; y <= lastY; ++y) {
+      for (x = firstX; x <= lastX && prefetcher->wantedCount != MAX_PREFETCH; ++x) {
+         key.x = (unsigned int)x;
+         key.y = (unsigned int)y;
+         if (!containsKey(prefetcher->wanted, prefetcher->wantedCount, key)) {
+            prefetcher->wanted[prefetcher->wantedCount++] = key;
+         }
+      }
+   }
+}
+
+static bool containsKey(const tileKey *keys, int count, tileKey key) {
+   int index;
+
+   for (index = 0; index != count; ++index) {
+      if (TilePyramid_compareKeys(&keys[index], &key) == 0) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+static double secondsNow(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -0,0 +1,51 @@
+#ifndef TILE_PREFETCHER_H
+#define TILE_PREFETCHER_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+#include "MandelbrotPool.h"
+#include "TileCache.h"
+
+// Speculative rendering of the tiles a client is about to ask for.
+//
+// Fed one client's viewport updates, it estimates pan and zoom velocity from
+// the recent ones, extrapolates where the viewport will be a little ahead, and
+// renders the tiles covering those positions into the cache as background
+// pool tasks. Renders are time-sliced and yield their thread whenever ordinary
+// (visible tile) work is queued, and are dropped once the prediction moves on.
+
+typedef struct {
+   // continuous tile level, the viewport shows level floor(zoom) tiles at
+   // 2^(zoom - floor(zoom)) screen pixels per tile pixel
+   real zoom;
+   mandelbrotCoord center;
+   // screen size in pixels
+   int width;
+   int height;
+} tileViewport;
+
+typedef struct tilePrefetcherData *TilePrefetcher;
+
+// borrows the cache and pool; the cache must outlive the prefetcher, the pool
+// any prefetch still queued on it
+// tiles deeper than maxLevel are never prefetched
+TilePrefetcher createTilePrefetcher(TileCache cache, MandelbrotPool pool, int maxIterations, int maxLevel);
+
+// abandons queued and running prefetches without waiting for them, the last
+// to stop releases what is left (nothing reaches the cache after this returns)
+void freeTilePrefetcher(TilePrefetcher prefetcher);
+
+// record where the client is now, and schedule the tiles it is heading towards
+void TilePrefetcher_updateViewport(TilePrefetcher prefetcher, const tileViewport *viewport);
+
+// for a caller about to render key itself: if a prefetch of it is rendering on a
+// pool thread, waits for it to reach the cache and returns true; one queued (not yet
+// started, or yielded to visible work) is dropped, and false returned, so the
+// caller's ordinary pool task renders it instead
+bool TilePrefetcher_awaitTile(TilePrefetcher prefetcher, tileKey key);
+
+// tiles rendered into the cache so far
+int TilePrefetcher_getRenderCount(TilePrefetcher prefetcher);
+
+#endif
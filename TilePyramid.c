@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "TilePyramid.h"
+#include "TileArchive.h"
+
+mandelbrotCoord TilePyramid_tileCenter(tileKey key) {
+   mandelbrotCoord center;
+
+   // width of a tile in fractal coordinates at this level
+   real tileWidth = TILE_PLANE_SIZE / (real)((unsigned long long)1 << key.z);
+
+   center.x = TILE_PLANE_LEFT + tileWidth * (key.x + 0.5);
+   center.y = TILE_PLANE_TOP  - tileWidth * (key.y + 0.5);
+
+   return center;
+}
+
+int TilePyramid_tileZoom(tileKey key) {
+   return key.z + TILE_ZOOM_OFFSET;
+}
+
+mandelbrotCoord TilePyramid_snapCenter(mandelbrotCoord center, int zoom, int width, int height) {
+   mandelbrotCoord snapped;
+   real resolution = 1.0/((real)((unsigned long long)1 << zoom));
+
+   // whole pixels from the plane's corner to the viewport's top-left corner
+   real left = roundl((center.x - (width  * resolution)/2.0 - TILE_PLANE_LEFT) / resolution);
+   real top  = roundl((TILE_PLANE_TOP - (center.y + (height * resolution)/2.0)) / resolution);
+
+   snapped.x = TILE_PLANE_LEFT + (left * resolution) + (width  * resolution)/2.0;
+   snapped.y = TILE_PLANE_TOP  - (top  * resolution) - (height * resolution)/2.0;
+
+   return snapped;
+}
+
+int TilePyramid_compareKeys(const void *a, const void *b) {
+   const tileKey *keyA = a;
+   const tileKey *keyB = b;
+   int result;
+
+   if (keyA->z != keyB->z) {
+      result = (keyA->z < keyB->z) ? -1 : 1;
+   } else if (keyA->y != keyB->y) {
+      result = (keyA->y < keyB->y) ? -1 : 1;
+   } else if (keyA->x != keyB->x) {
+      result = (keyA->x < keyB->x) ? -1 : 1;
+   } else {
+      result = 0;
+   }
+
+   return result;
+}
+
+void TilePyramid_renderTile(MandelbrotSet fractal, tileKey key) {
+   MandelbrotSet_setPosition(fractal, TilePyramid_tileCenter(key), TilePyramid_tileZoom(key));
+   MandelbrotSet_fastGenerate(fractal);
+}
+
+bool TilePyramid_writeArchive(const char *path, int levels, int maxIterations) {
+   tileKey key;
+   unsigned int tilesAcross;
+   bool isWritten;
+
+   TileArchiveWriter writer = createTileArchiveWriter(path, TILE_SIZE, maxIterations);
+   if (writer == NULL) {
+      return false;
+   }
+
+   MandelbrotSet fractal = createMandelbrotSet(TILE_SIZE, TILE_SIZE);
+   MandelbrotSet_setMaxIterations(fractal, maxIterations);
+
+   for (key.z = 0; key.z != (unsigned int)levels; ++key.z) {
+      tilesAcross = 1u << key.z;
+      for (key.y = 0; key.y != tilesAcross; ++key.y) {
+         for (key.x = 0; key.x != tilesAcross; ++key.x) {
+            TilePyramid_renderTile(fractal, key);
+            TileArchiveWriter_addTile(writer, key, MandelbrotSet_getScores(fractal));
+         }
+      }
+   }
+
+   freeMandelbrotSet(fractal);
+
+   isWritten = closeTileArchiveWriter(writer);
+   return isWritten;
+}
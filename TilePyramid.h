@@ -0,0 +1,47 @@
+#ifndef TILE_PYRAMID_H
+#define TILE_PYRAMID_H
+
+#include <stdbool.h>
+
+#include "MandelbrotSet.h"
+
+// every tile is a square of TILE_SIZE x TILE_SIZE pixels
+#define TILE_SIZE 256
+
+// level 0 is a single tile covering [-2, 2] x [-2, 2],
+// so its pixels are 4/TILE_SIZE = 2^-6 fractal units apart
+#define TILE_ZOOM_OFFSET 6
+#define TILE_PLANE_LEFT -2.0
+#define TILE_PLANE_TOP   2.0
+#define TILE_PLANE_SIZE  4.0
+
+typedef struct {
+   unsigned int z;
+   unsigned int x;
+   unsigned int y;
+} tileKey;
+
+// fractal coordinate at the center of a tile
+mandelbrotCoord TilePyramid_tileCenter(tileKey key);
+
+// zoom to pass to MandelbrotSet_setPosition for tiles at this key's level
+int TilePyramid_tileZoom(tileKey key);
+
+// the center nearest to center of a width x height viewport at zoom whose pixel
+// centers lie on the pyramid's lattice, i.e. coincide with pixels of level zoom - 6 tiles
+mandelbrotCoord TilePyramid_snapCenter(mandelbrotCoord center, int zoom, int width, int height);
+
+// orders keys by level, then row, then column (qsort/bsearch compatible)
+int TilePyramid_compareKeys(const void *a, const void *b);
+
+// render a single tile into a fractal created with TILE_SIZE x TILE_SIZE
+// tiles must be rendered under the built-in profile (no MandelbrotSet_loadProfile):
+// the profile can change fastGenerate's output, and archives and caches built on
+// different machines have to agree bit for bit
+void TilePyramid_renderTile(MandelbrotSet fractal, tileKey key);
+
+// render every tile of levels [0, levels) into a packed archive at path
+// returns false if the archive could not be written
+bool TilePyramid_writeArchive(const char *path, int levels, int maxIterations);
+
+#endif
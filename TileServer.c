@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "TileServer.h"
+#include "TilePrefetcher.h"
+#include "MandelbrotAsync.h"
+#include "FileIO.h"
+
+struct tileServerData {
+   TileArchive archive;
+
+   // NULL unless rendering is enabled
+   TileCache cache;
+   MandelbrotPool pool;
+   int maxIterations;
+   int maxLevel;
+};
+
+// bounds on the pause after accept runs out of descriptors or memory, doubling while it persists
+#define ACCEPT_BACKOFF_MIN_MS 10
+#define ACCEPT_BACKOFF_MAX_MS 1000
+
+// a provisional tile is cropped from an ancestor at most this many levels up,
+// beyond that a crop is too few pixels to be worth showing
+#define PROVISIONAL_MAX_DEPTH 4
+
+// per connection state for a rendering server
+typedef struct {
+   TilePrefetcher prefetcher;
+   MandelbrotSet fractal;
+   unsigned char *payload;
+   size_t capacity;
+
+   // TILE_SIZE grids for building provisional tiles, rows point into one block
+   int **ancestor;
+   int **provisional;
+} renderState;
+
+typedef struct {
+   TileServer server;
+   int fd;
+} connection;
+
+static void *serveConnection(void *data);
+
+static bool sendHeader(int fd, uint32_t status, uint32_t flags, uint32_t length);
+
+// answer a request the archive can't, from the cache or by rendering
+static bool sendRendered(TileServer server, renderState *state, int fd, tileKey key, bool isProvisionalAccepted);
+
+// send an upsampled crop of the nearest available ancestor, if there is one
+// returns false only if the connection failed
+static bool sendProvisional(TileServer server, renderState *state, int fd, tileKey key);
+static bool findAncestor(TileServer server, renderState *state, tileKey key, int depth);
+
+static int **createGrid(int size);
+static void freeGrid(int **grid);
+
+// read the rest of a viewport message and hand it to the prefetcher
+static bool receiveViewport(TileServer server, renderState *state, int fd, const tileRequest *request);
+
+
+TileServer createTileServer(TileArchive archive) {
+   TileServer server = malloc(sizeof (struct tileServerData));
+   assert(server != NULL);
+
+   server->archive = archive;
+   server->cache = NULL;
+   server->pool = NULL;
+
+   return server;
+}
+
+void freeTileServer(TileServer server) {
+   free(server);
+}
+
+bool TileServer_enableRendering(TileServer server, TileCache cache, MandelbrotPool pool,
+                                int maxIterations, int maxLevel) {
+   // tile columns must fit the protocol's 32 bit coordinates
+   assert(maxLevel >= 0 && maxLevel < 32);
+
+   if (server->archive != NULL && TileArchive_getMaxIterations(server->archive) != maxIterations) {
+      return false;
+   }
+
+   server->cache = cache;
+   server->pool = pool;
+   server->maxIterations = maxIterations;
+   server->maxLevel = maxLevel;
+
+   return true;
+}
+
+bool TileServer_run(TileServer server, int listenFd) {
+   pthread_t thread;
+   connection *client;
+   int fd;
+   int noDelay = 1;
+   int backoff = 0;
+   struct timespec pause;
+
+   while (true) {
+      fd = accept(listenFd, NULL, NULL);
+      if (fd < 0) {
+         if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) {
+            // this connection only, the next may be fine
+            continue;
+         } else if (errno != EMFILE && errno != ENFILE && errno != ENOBUFS && errno != ENOMEM) {
+            // the listening socket itself is broken
+            perror("accept");
+            return false;
+         }
+
+         // out of descriptors or memory until some connections close, retrying at once
+         // would spin, so wait a little longer each time it persists
+         if (backoff == 0) {
+            perror("accept");
+            backoff = ACCEPT_BACKOFF_MIN_MS;
+         } else if (backoff < ACCEPT_BACKOFF_MAX_MS) {
+            backoff = (2 * backoff < ACCEPT_BACKOFF_MAX_MS) ? 2 * backoff : ACCEPT_BACKOFF_MAX_MS;
+         }
+         pause.tv_sec = backoff / 1000;
+         pause.tv_nsec = (long)(backoff % 1000) * 1000000;
+         nanosleep(&pause, NULL);
+         continue;
+      }
+      backoff = 0;
+
+      // a response is a header then a payload, don't let Nagle hold the payload back
+      // waiting for the client's delayed ack (harmlessly fails on non-TCP sockets)
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof noDelay);
+
+      client = malloc(sizeof (connection));
+      assert(client != NULL);
+      client->server = server;
+      client->fd = fd;
+
+      if (pthread_create(&thread, NULL, serveConnection, client) != 0) {
+         close(fd);
+         free(client);
+      } else {
+         pthread_detach(thread);
+      }
+   }
+}
+
+
+// Static functions
+
+static void *serveConnection(void *data) {
+   connection *client = data;
+   TileServer server = client->server;
+   int fd = client->fd;
+   free(client);
+
+   tileRequest request;
+   tileKey key;
+   const tileArchiveEntry *entry;
+   bool isOpen = true;
+   renderState state;
+
+   if (server->cache != NULL) {
+      state.prefetcher = createTilePrefetcher(server->cache, server->pool, server->maxIterations, server->maxLevel);
+      state.fractal = createMandelbrotSet(TILE_SIZE, TILE_SIZE);
+      MandelbrotSet_setMaxIterations(state.fractal, server->maxIterations);
+      state.payload = NULL;
+      state.capacity = 0;
+      state.ancestor = createGrid(TILE_SIZE);
+      state.provisional = createGrid(TILE_SIZE);
+   }
+
+   while (isOpen && FileIO_readFully(fd, &request, sizeof request)) {
+      if (ntohl(request.z) == TILE_VIEWPORT_MARKER) {
+         isOpen = receiveViewport(server, &state, fd, &request);
+         continue;
+      }
+
+      key.z = ntohl(request.z) & ~TILE_REQUEST_PROVISIONAL;
+      key.x = ntohl(request.x);
+      key.y = ntohl(request.y);
+
+      entry = (server->archive != NULL) ? TileArchive_find(server->archive, key) : NULL;
+      if (entry != NULL) {
+         isOpen = sendHeader(fd, TILE_STATUS_OK, 0, entry->length) &&
+                  TileArchive_sendTile(server->archive, entry, fd) >= 0;
+      } else if (server->cache != NULL) {
+         isOpen = sendRendered(server, &state, fd, key, (ntohl(request.z) & TILE_REQUEST_PROVISIONAL) != 0);
+      } else {
+         isOpen = sendHeader(fd, TILE_STATUS_MISSING, 0, 0);
+      }
+   }
+
+   if (server->cache != NULL) {
+      freeTilePrefetcher(state.prefetcher);
+      freeMandelbrotSet(state.fractal);
+      free(state.payload);
+      freeGrid(state.ancestor);
+      freeGrid(state.provisional);
+   }
+
+   close(fd);
+   return NULL;
+}
+
+static bool sendHeader(int fd, uint32_t status, uint32_t flags, uint32_t length) {
+   tileResponseHeader header;
+
+   header.status = htonl(status);
+   header.flags  = htonl(flags);
+   header.length = htonl(length);
+
+   return FileIO_writeFully(fd, &header, sizeof header);
+}
+
+static bool sendRendered(TileServer server, renderState *state, int fd, tileKey key, bool isProvisionalAccepted) {
+   size_t length;
+
+   if (key.z > (unsigned int)server->maxLevel || key.x >= (1u << key.z) || key.y >= (1u << key.z)) {
+      return sendHeader(fd, TILE_STATUS_MISSING, 0, 0);
+   }
+
+   if (!TileCache_get(server->cache, key, &state->payload, &state->capacity, &length)) {
+      // the client sees something now, the exact tile replaces it once rendered
+      if (isProvisionalAccepted && !sendProvisional(server, state, fd, key)) {
+         return false;
+      }
+
+      // a prefetch already partway through the tile is cheaper to finish than to repeat
+      if (!TilePrefetcher_awaitTile(state->prefetcher, key) ||
+          !TileCache_get(server->cache, key, &state->payload, &state->capacity, &length)) {
+         // an ordinary pool task, so background prefetches yield to it
+         MandelbrotSet_setPosition(state->fractal, TilePyramid_tileCenter(key), TilePyramid_tileZoom(key));
+         freeMandelbrotRender(MandelbrotSet_generateAsync(state->fractal, server->pool, MANDELBROT_FAST_GENERATE));
+
+         length = TileArchive_encodeScores(MandelbrotSet_getScores(state->fractal), TILE_SIZE,
+                                           &state->payload, &state->capacity);
+         TileCache_put(server->cache, key, state->payload, length);
+      }
+   }
+
+   return sendHeader(fd, TILE_STATUS_OK, 0, length) &&
+          FileIO_writeFully(fd, state->payload, length);
+}
+
+static bool receiveViewport(TileServer server, renderState *state, int fd, const tileRequest *request) {
+   tileViewportMessage message;
+   tileViewport viewport;
+   unsigned int level;
+   real pixelSize;
+
+   // the request already read is the message's first three words
+   memcpy(&message, request, sizeof *request);
+   if (!FileIO_readFully(fd, (char *)&message + sizeof *request, sizeof message - sizeof *request)) {
+      return false;
+   }
+
+   level = ntohl(message.level);
+   if (server->cache == NULL || level > (unsigned int)server->maxLevel || level > TILE_VIEWPORT_MAX_LEVEL) {
+      // nothing to prefetch into, nowhere we would render, or a center we can't place
+      return true;
+   }
+
+   pixelSize = TILE_PLANE_SIZE / TILE_SIZE / (real)(1ULL << level);
+   viewport.zoom = level + (real)ntohl(message.zoomFraction) / TILE_ZOOM_FRACTION_ONE;
+   viewport.center.x = TILE_PLANE_LEFT + ntohl(message.centerX) * pixelSize;
+   viewport.center.y = TILE_PLANE_TOP - ntohl(message.centerY) * pixelSize;
+   viewport.width = ntohl(message.width);
+   viewport.height = ntohl(message.height);
+
+   TilePrefetcher_updateViewport(state->prefetcher, &viewport);
+
+   return true;
+}
+
+static bool sendProvisional(TileServer server, renderState *state, int fd, tileKey key) {
+   int depth, row, col;
+   int span, top, left;
+   size_t length;
+
+   for (depth = 1; depth <= PROVISIONAL_MAX_DEPTH && (unsigned int)depth <= key.z; ++depth) {
+      if (!findAncestor(server, state, key, depth)) {
+         continue;
+      }
+
+      // the ancestor pixels covering this tile, each stretched over 2^depth pixels
+      span = TILE_SIZE >> depth;
+      left = (key.x & ((1u << depth) - 1)) * span;
+      top  = (key.y & ((1u << depth) - 1)) * span;
+      for (row = 0; row != TILE_SIZE; ++row) {
+         for (col = 0; col != TILE_SIZE; ++col) {
+            state->provisional[row][col] = state->ancestor[top + (row >> depth)][left + (col >> depth)];
+         }
+      }
+
+      length = TileArchive_encodeScores(state->provisional, TILE_SIZE, &state->payload, &state->capacity);
+      return sendHeader(fd, TILE_STATUS_OK, TILE_FLAG_PROVISIONAL, length) &&
+             FileIO_writeFully(fd, state->payload, length);
+   }
+
+   return true;
+}
+
+static bool findAncestor(TileServer server, renderState *state, tileKey key, int depth) {
+   tileKey ancestor;
+   size_t length;
+
+   ancestor.z = key.z - depth;
+   ancestor.x = key.x >> depth;
+   ancestor.y = key.y >> depth;
+
+   if (server->archive != NULL && TileArchive_getTileSize(server->archive) == TILE_SIZE &&
+       TileArchive_readTile(server->archive, ancestor, state->ancestor)) {
+      return true;
+   }
+
+   return TileCache_get(server->cache, ancestor, &state->payload, &state->capacity, &length) &&
+          TileArchive_decodeScores(state->payload, length, state->ancestor, TILE_SIZE);
+}
+
+static int **createGrid(int size) {
+   int row;
+
+   int **grid = malloc(sizeof (int *) * size);
+   assert(grid != NULL);
+   grid[0] = malloc(sizeof (int) * size * size);
+   assert(grid[0] != NULL);
+   for (row = 1; row != size; ++row) {
+      grid[row] = grid[0] + (size_t)row * size;
+   }
+
+   return grid;
+}
+
+static void freeGrid(int **grid) {
+   free(grid[0]);
+   free(grid);
+}
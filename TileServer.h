@@ -0,0 +1,87 @@
+#ifndef TILE_SERVER_H
+#define TILE_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "TileArchive.h"
+#include "TileCache.h"
+#include "MandelbrotPool.h"
+
+// Wire protocol, all fields uint32 in network byte order
+//
+//    request  | z, x, y
+//    response | status, flags, length, then length bytes of encoded scores
+//
+//    viewport | TILE_VIEWPORT_MARKER, level, zoomFraction, centerX, centerY, width, height
+//               (no response)
+//
+// the payload uses the archive's run-length encoding (TileArchive_decodeScores)
+//
+// A viewport message tells a rendering server where the client is looking, so it can
+// prefetch where the client is heading: the screen is width x height pixels showing
+// level tiles magnified by 2^(zoomFraction / 65536), centered on pixel (centerX, centerY)
+// of that level's pixel grid. It starts with the same three words as a request.
+//
+// A request whose z has TILE_REQUEST_PROVISIONAL set accepts a degraded answer: if the
+// tile has to be rendered and an ancestor is at hand, a crop of the ancestor upsampled
+// to full size is sent at once with TILE_FLAG_PROVISIONAL, and the exact tile follows
+// as a second response to the same request (before the response to any later one).
+
+#define TILE_STATUS_OK      0
+#define TILE_STATUS_MISSING 1
+
+#define TILE_FLAG_PROVISIONAL 1
+
+#define TILE_REQUEST_PROVISIONAL 0x80000000u
+
+#define TILE_VIEWPORT_MARKER 0xffffffffu
+#define TILE_ZOOM_FRACTION_ONE 65536
+
+// a viewport's 32 bit center addresses a pixel grid 2^level * TILE_SIZE wide, so
+// viewports deeper than this can't be described and are ignored (tiles still render)
+#define TILE_VIEWPORT_MAX_LEVEL 24
+
+typedef struct {
+   uint32_t z;
+   uint32_t x;
+   uint32_t y;
+} tileRequest;
+
+typedef struct {
+   uint32_t marker;
+   uint32_t level;
+   uint32_t zoomFraction;
+   uint32_t centerX;
+   uint32_t centerY;
+   uint32_t width;
+   uint32_t height;
+} tileViewportMessage;
+
+typedef struct {
+   uint32_t status;
+   uint32_t flags;
+   uint32_t length;
+} tileResponseHeader;
+
+typedef struct tileServerData *TileServer;
+
+// borrows the archive, which must outlive the server
+// archive may be NULL for a server that only renders
+TileServer createTileServer(TileArchive archive);
+
+// render tiles missing from the archive (up to maxLevel, below 32) on the pool, keeping them
+// in the cache, and prefetch for clients that send viewport updates
+// borrows the cache and pool, which must outlive the server
+// returns false, leaving rendering off, if maxIterations differs from the archive's,
+// as rendered tiles would then not match the archived ones
+bool TileServer_enableRendering(TileServer server, TileCache cache, MandelbrotPool pool,
+                                int maxIterations, int maxLevel);
+
+void freeTileServer(TileServer server);
+
+// accept connections on a listening socket forever, serving each on its own thread
+// pauses while out of descriptors, returns false only if the listening socket fails
+bool TileServer_run(TileServer server, int listenFd);
+
+#endif
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "Trace.h"
+
+// events per chunk, a buffer grows a chunk at a time so nothing is ever moved
+#define CHUNK_EVENTS 4096
+
+typedef struct {
+   const char *name;
+   const char *category;
+   uint64_t start;
+   uint64_t end;
+   int tile;
+   long pixels;
+} traceEvent;
+
+typedef struct traceChunk {
+   traceEvent events[CHUNK_EVENTS];
+   // written only by the owning thread, stored with release so a concurrent
+   // writer of the trace sees complete events
+   atomic_int count;
+   _Atomic(struct traceChunk *) next;
+} traceChunk;
+
+typedef struct traceBuffer {
+   int threadId;
+   traceChunk *first;
+   traceChunk *last;
+   struct traceBuffer *next;
+} traceBuffer;
+
+atomic_bool traceIsEnabled = false;
+
+static _Atomic(traceBuffer *) buffers = NULL;
+static atomic_int nextThreadId = 1;
+static _Thread_local traceBuffer *threadBuffer = NULL;
+
+static uint64_t traceOrigin = 0;
+
+static traceBuffer *createBuffer(void);
+static traceChunk *createChunk(void);
+
+
+void Trace_setEnabled(bool isEnabled) {
+   if (isEnabled && traceOrigin == 0) {
+      traceOrigin = Trace_now();
+   }
+   atomic_store_explicit(&traceIsEnabled, isEnabled, memory_order_relaxed);
+}
+
+uint64_t Trace_now(void) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void Trace_record(const char *name, const char *category, uint64_t start, int tile, long pixels) {
+   traceChunk *chunk;
+   traceEvent *event;
+   int count;
+
+   if (!Trace_isEnabled()) {
+      return;
+   }
+
+   if (threadBuffer == NULL) {
+      threadBuffer = createBuffer();
+   }
+
+   chunk = threadBuffer->last;
+   count = atomic_load_explicit(&chunk->count, memory_order_relaxed);
+   if (count == CHUNK_EVENTS) {
+      chunk = createChunk();
+      atomic_store_explicit(&threadBuffer->last->next, chunk, memory_order_release);
+      threadBuffer->last = chunk;
+      count = 0;
+   }
+
+   event = &chunk->events[count];
+   event->name = name;
+   event->category = category;
+   event->start = start;
+   event->end = Trace_now();
+   event->tile = tile;
+   event->pixels = pixels;
+
+   atomic_store_explicit(&chunk->count, count + 1, memory_order_release);
+}
+
+bool Trace_write(const char *path) {
+   traceBuffer *buffer;
+   traceChunk *chunk;
+   traceEvent *event;
+   int index, count;
+   bool isFirst = true;
+   bool isWritten;
+
+   FILE *file = fopen(path, "w");
+   if (file == NULL) {
+      return false;
+   }
+
+   fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+   for (buffer = atomic_load_explicit(&buffers, memory_order_acquire); buffer != NULL; buffer = buffer->next) {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+              isFirst ? "" : ",\n", buffer->threadId, buffer->threadId);
+      isFirst = false;
+
+      for (chunk = buffer->first; chunk != NULL; chunk = atomic_load_explicit(&chunk->next, memory_order_acquire)) {
+         count = atomic_load_explicit(&chunk->count, memory_order_acquire);
+
+         for (index = 0; index != count; ++index) {
+            event = &chunk->events[index];
+            // complete events, timestamps in microseconds from when tracing was enabled
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                          "\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                    event->name, event->category, buffer->threadId,
+                    (event->start - traceOrigin) / 1000.0, (event->end - event->start) / 1000.0);
+            if (event->tile != TRACE_NO_VALUE) {
+               fprintf(file, "\"tile\":%d%s", event->tile, (event->pixels != TRACE_NO_VALUE) ? "," : "");
+            }
+            if (event->pixels != TRACE_NO_VALUE) {
+               fprintf(file, "\"pixels\":%ld", event->pixels);
+            }
+            fprintf(file, "}}");
+         }
+      }
+   }
+
+   fprintf(file, "\n]}\n");
+
+   isWritten = !ferror(file);
+   isWritten = (fclose(file) == 0) && isWritten;
+
+   return isWritten;
+}
+
+
+// Static functions
+
+static traceBuffer *createBuffer(void) {
+   traceBuffer *buffer = malloc(sizeof (traceBuffer));
+   assert(buffer != NULL);
+
+   buffer->threadId = atomic_fetch_add_explicit(&nextThreadId, 1, memory_order_relaxed);
+   buffer->first = createChunk();
+   buffer->last = buffer->first;
+
+   // push onto the global list, the buffer is complete before it is visible
+   buffer->next = atomic_load_explicit(&buffers, memory_order_relaxed);
+   while (!atomic_compare_exchange_weak_explicit(&buffers, &buffer->next, buffer,
+                                                 memory_order_release, memory_order_relaxed)) {
+      // another thread registered first, retry against the new head
+   }
+
+   return buffer;
+}
+
+static traceChunk *createChunk(void) {
+   traceChunk *chunk = malloc(sizeof (traceChunk));
+   assert(chunk != NULL);
+
+   atomic_init(&chunk->count, 0);
+   atomic_init(&chunk->next, NULL);
+
+   return chunk;
+}
@@ -0,0 +1,38 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Lightweight timeline tracing, exported as Chrome trace-event JSON
+// (load in chrome://tracing or ui.perfetto.dev).
+//
+// Each thread appends to its own buffer without locking; buffers are linked
+// into a global list once, on the thread's first event, and outlive the thread
+// so a pool can be shut down before the trace is written.
+// When tracing is off every hook is a single relaxed load and a branch.
+//
+// names and categories must be string literals (or otherwise outlive the trace)
+
+#define TRACE_NO_VALUE -1
+
+extern atomic_bool traceIsEnabled;
+
+static inline bool Trace_isEnabled(void) {
+   return atomic_load_explicit(&traceIsEnabled, memory_order_relaxed);
+}
+
+void Trace_setEnabled(bool isEnabled);
+
+// monotonic time in nanoseconds, the timestamp events are recorded with
+uint64_t Trace_now(void);
+
+// record a span from start until now on the calling thread
+// tile and pixels are shown as event arguments unless TRACE_NO_VALUE
+void Trace_record(const char *name, const char *category, uint64_t start, int tile, long pixels);
+
+// write every buffered event, returns false if the file could not be written
+bool Trace_write(const char *path);
+
+#endif
@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#include "ZoomKeyframes.h"
+
+#define NO_KEYFRAME -1
+#define KEYFRAME_SLOTS 2
+
+// frame pixels over which the finer keyframe fades in from its edge, at the start
+// of a step; the band narrows to nothing as the keyframe grows to cover the frame
+#define BLEND_PIXELS 24.0f
+
+typedef struct {
+   int zoom;
+   // (2 * width) x (2 * height) scores, converted once so resampling is float only
+   float *samples;
+} keyframe;
+
+// where each frame row or column lands in a keyframe
+typedef struct {
+   int *index;
+   float *fraction;
+   // the range of frame pixels that fall inside the keyframe
+   int first;
+   int last;
+   // 0 at the keyframe's edge rising to 1 a blend band inside it
+   float *edgeWeight;
+} sampleTable;
+
+struct zoomKeyframesData {
+   int width;
+   int height;
+   mandelbrotCoord center;
+
+   MandelbrotSet renderer;
+   keyframe slots[KEYFRAME_SLOTS];
+   int renderCount;
+
+   // per frame lookup tables for the coarse and fine keyframes
+   sampleTable columns[KEYFRAME_SLOTS];
+   sampleTable rows[KEYFRAME_SLOTS];
+
+   // one row of blended output before rounding, the finer keyframe's row,
+   // and how much of it to take per column
+   float *rowBuffer;
+   float *fineBuffer;
+   float *blendWeights;
+};
+
+static const keyframe *getKeyframe(ZoomKeyframes keyframes, int zoom, int keepZoom);
+
+// map frame pixels 0..frameSize-1 into a keyframe of keyframeSize samples,
+// where one frame pixel is scale keyframe samples, fading in over blendPixels
+static void buildSampleTable(sampleTable *table, int frameSize, int keyframeSize, float scale, float blendPixels);
+
+// out[i] = lerp(lerp(top[i], top[i+1]), lerp(bottom[i], bottom[i+1])) over a frame row,
+// written as straight-line float arithmetic for the auto-vectorizer
+static void resampleRow(const keyframe *source, int keyframeWidth, const sampleTable *columns,
+                        int sourceRow, float rowFraction, float *out);
+
+static void allocateSampleTable(sampleTable *table, int size);
+static void freeSampleTable(sampleTable *table);
+
+
+ZoomKeyframes createZoomKeyframes(int width, int height, mandelbrotCoord center) {
+   int slot;
+
+   ZoomKeyframes keyframes = malloc(sizeof (struct zoomKeyframesData));
+   assert(keyframes != NULL);
+
+   keyframes->width = width;
+   keyframes->height = height;
+   keyframes->center = center;
+
+   keyframes->renderer = createMandelbrotSet(2 * width, 2 * height);
+   keyframes->renderCount = 0;
+
+   for (slot = 0; slot != KEYFRAME_SLOTS; ++slot) {
+      keyframes->slots[slot].zoom = NO_KEYFRAME;
+      keyframes->slots[slot].samples = malloc(sizeof (float) * 4 * width * height);
+      assert(keyframes->slots[slot].samples != NULL);
+
+      allocateSampleTable(&keyframes->columns[slot], width);
+      allocateSampleTable(&keyframes->rows[slot], height);
+   }
+
+   keyframes->rowBuffer = malloc(sizeof (float) * width);
+   keyframes->fineBuffer = malloc(sizeof (float) * width);
+   keyframes->blendWeights = malloc(sizeof (float) * width);
+   assert(keyframes->rowBuffer != NULL && keyframes->fineBuffer != NULL && keyframes->blendWeights != NULL);
+
+   return keyframes;
+}
+
+void freeZoomKeyframes(ZoomKeyframes keyframes) {
+   int slot;
+
+   for (slot = 0; slot != KEYFRAME_SLOTS; ++slot) {
+      free(keyframes->slots[slot].samples);
+      freeSampleTable(&keyframes->columns[slot]);
+      freeSampleTable(&keyframes->rows[slot]);
+   }
+
+   free(keyframes->rowBuffer);
+   free(keyframes->fineBuffer);
+   free(keyframes->blendWeights);
+   freeMandelbrotSet(keyframes->renderer);
+   free(keyframes);
+}
+
+void ZoomKeyframes_setMaxIterations(ZoomKeyframes keyframes, int maxIterations) {
+   int slot;
+
+   MandelbrotSet_setMaxIterations(keyframes->renderer, maxIterations);
+
+   // keyframes rendered with the old limit are stale
+   for (slot = 0; slot != KEYFRAME_SLOTS; ++slot) {
+      keyframes->slots[slot].zoom = NO_KEYFRAME;
+   }
+}
+
+void ZoomKeyframes_renderFrame(ZoomKeyframes keyframes, real zoom, int **frame) {
+   int row, col;
+   int keyframeWidth = 2 * keyframes->width;
+   int keyframeHeight = 2 * keyframes->height;
+   int level = (int)floorl(zoom);
+   float progress = (float)(zoom - level);
+   float scale, rowWeight;
+   float *out = keyframes->rowBuffer;
+   float *fineOut = keyframes->fineBuffer;
+   float *blend = keyframes->blendWeights;
+
+   // the keyframe at this step covers the frame, the next one only its center
+   const keyframe *coarse = getKeyframe(keyframes, level, level + 1);
+   const keyframe *fine = getKeyframe(keyframes, level + 1, level);
+   const keyframe *sources[KEYFRAME_SLOTS] = { coarse, fine };
+
+   // a fixed band would still be showing when the finer keyframe takes over the
+   // whole frame at the next step, so it narrows to nothing by then
+   float blendPixels[KEYFRAME_SLOTS] = { 0, BLEND_PIXELS * (1.0f - progress) };
+
+   int source;
+   const sampleTable *columns;
+   const sampleTable *rows;
+
+   for (source = 0; source != KEYFRAME_SLOTS; ++source) {
+      // a keyframe at zoom k has samples 2^-(k+1) apart
+      scale = (float)exp2l((sources[source]->zoom + 1) - zoom);
+      buildSampleTable(&keyframes->columns[source], keyframes->width, keyframeWidth, scale, blendPixels[source]);
+      buildSampleTable(&keyframes->rows[source], keyframes->height, keyframeHeight, scale, blendPixels[source]);
+   }
+
+   for (row = 0; row != keyframes->height; ++row) {
+      memset(out, 0, sizeof (float) * keyframes->width);
+
+      columns = &keyframes->columns[0];
+      rows = &keyframes->rows[0];
+      resampleRow(coarse, keyframeWidth, columns, rows->index[row], rows->fraction[row], out);
+
+      // cross-fade towards the finer keyframe where it has data, fading its share
+      // in from its edge so its border doesn't show as a hard seam
+      columns = &keyframes->columns[1];
+      rows = &keyframes->rows[1];
+      if (row >= rows->first && row <= rows->last) {
+         resampleRow(fine, keyframeWidth, columns, rows->index[row], rows->fraction[row], fineOut);
+
+         rowWeight = progress * rows->edgeWeight[row];
+         for (col = columns->first; col <= columns->last; ++col) {
+            blend[col] = rowWeight * columns->edgeWeight[col];
+         }
+         for (col = columns->first; col <= columns->last; ++col) {
+            out[col] += blend[col] * (fineOut[col] - out[col]);
+         }
+      }
+
+      for (col = 0; col != keyframes->width; ++col) {
+         frame[row][col] = (int)(out[col] + 0.5f);
+      }
+   }
+}
+
+int ZoomKeyframes_getRenderCount(ZoomKeyframes keyframes) {
+   return keyframes->renderCount;
+}
+
+
+// Static functions
+
+static const keyframe *getKeyframe(ZoomKeyframes keyframes, int zoom, int keepZoom) {
+   int slot;
+   int row, col;
+   int keyframeWidth = 2 * keyframes->width;
+   int keyframeHeight = 2 * keyframes->height;
+   int **scores;
+   keyframe *target = NULL;
+
+   for (slot = 0; slot != KEYFRAME_SLOTS; ++slot) {
+      if (keyframes->slots[slot].zoom == zoom) {
+         return &keyframes->slots[slot];
+      }
+   }
+
+   // evict whichever slot isn't holding the other keyframe this frame needs
+   target = &keyframes->slots[0];
+   if (target->zoom == keepZoom) {
+      target = &keyframes->slots[1];
+   }
+
+   // oversized and one step deeper, covering the whole frame at zoom
+   MandelbrotSet_setPosition(keyframes->renderer, keyframes->center, zoom + 1);
+   MandelbrotSet_fastGenerate(keyframes->renderer);
+   scores = MandelbrotSet_getScores(keyframes->renderer);
+
+   for (row = 0; row != keyframeHeight; ++row) {
+      for (col = 0; col != keyframeWidth; ++col) {
+         target->samples[(size_t)row * keyframeWidth + col] = (float)scores[row][col];
+      }
+   }
+
+   target->zoom = zoom;
+   keyframes->renderCount++;
+
+   return target;
+}
+
+static void buildSampleTable(sampleTable *table, int frameSize, int keyframeSize, float scale, float blendPixels) {
+   int pixel;
+   float position, edgeDistance;
+   int index;
+
+   table->first = frameSize;
+   table->last = -1;
+
+   for (pixel = 0; pixel != frameSize; ++pixel) {
+      // frame pixel center, relative to the center, in keyframe samples
+      position = (pixel + 0.5f - frameSize / 2.0f) * scale + keyframeSize / 2.0f - 0.5f;
+
+      if (position >= 0 && position <= keyframeSize - 1) {
+         if (pixel < table->first) {
+            table->first = pixel;
+         }
+         table->last = pixel;
+
+         // in frame pixels, to whichever edge is nearer
+         edgeDistance = ((position < keyframeSize - 1 - position) ? position : keyframeSize - 1 - position) / scale;
+         table->edgeWeight[pixel] = (edgeDistance >= blendPixels) ? 1.0f : edgeDistance / blendPixels;
+      } else {
+         position = (position < 0) ? 0 : keyframeSize - 1;
+         table->edgeWeight[pixel] = 0;
+      }
+
+      index = (int)position;
+      if (index == keyframeSize - 1) {
+         // keep index + 1 in bounds, the fraction then selects index exactly
+         index--;
+      }
+
+      table->index[pixel] = index;
+      table->fraction[pixel] = position - index;
+   }
+}
+
+static void resampleRow(const keyframe *source, int keyframeWidth, const sampleTable *columns,
+                        int sourceRow, float rowFraction, float *out) {
+   int col;
+   const float *top = source->samples + (size_t)sourceRow * keyframeWidth;
+   const float *bottom = top + keyframeWidth;
+   const int *index = columns->index;
+   const float *fraction = columns->fraction;
+   float upper, lower;
+
+   for (col = columns->first; col <= columns->last; ++col) {
+      upper = top[index[col]] + fraction[col] * (top[index[col] + 1] - top[index[col]]);
+      lower = bottom[index[col]] + fraction[col] * (bottom[index[col] + 1] - bottom[index[col]]);
+      out[col] = upper + rowFraction * (lower - upper);
+   }
+}
+
+static void allocateSampleTable(sampleTable *table, int size) {
+   table->index = malloc(sizeof (int) * size);
+   table->fraction = malloc(sizeof (float) * size);
+   table->edgeWeight = malloc(sizeof (float) * size);
+   assert(table->index != NULL && table->fraction != NULL && table->edgeWeight != NULL);
+}
+
+static void freeSampleTable(sampleTable *table) {
+   free(table->index);
+   free(table->fraction);
+   free(table->edgeWeight);
+}
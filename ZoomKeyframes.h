@@ -0,0 +1,29 @@
+#ifndef ZOOM_KEYFRAMES_H
+#define ZOOM_KEYFRAMES_H
+
+#include "MandelbrotSet.h"
+
+// Zoom video by interpolation: a keyframe is rendered once per whole zoom step,
+// at twice the frame size and one zoom deeper, so it covers every frame up to
+// the next step with at least one sample per frame pixel. In-between frames
+// are resampled from the two keyframes either side and cross-faded, the finer
+// one fading in from its edge so the boundary between them doesn't show.
+
+typedef struct zoomKeyframesData *ZoomKeyframes;
+
+// frames are width x height, all centered on center
+ZoomKeyframes createZoomKeyframes(int width, int height, mandelbrotCoord center);
+
+void freeZoomKeyframes(ZoomKeyframes keyframes);
+
+void ZoomKeyframes_setMaxIterations(ZoomKeyframes keyframes, int maxIterations);
+
+// fill a width x height grid with the frame at a fractional zoom
+// (as for MandelbrotSet_setPosition, pixels are 2^-zoom apart)
+// keyframes are rendered as needed, and the last two are kept
+void ZoomKeyframes_renderFrame(ZoomKeyframes keyframes, real zoom, int **frame);
+
+// number of keyframes rendered so far
+int ZoomKeyframes_getRenderCount(ZoomKeyframes keyframes);
+
+#endif
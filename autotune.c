@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+#include "MandelbrotSet.h"
+#include "BenchViews.h"
+
+// Picks the fastest tile size and fastGenerate block cutoff for this machine
+// and writes them as a profile, for MandelbrotSet_loadProfile.
+//
+// usage: autotune profile
+//
+// runs a shortened benchmark (every catalogue view at a quarter of its area,
+// best of TUNE_RUNS) and sweeps one parameter at a time, tile size first
+//
+// both parameters can change what fastGenerate guesses, so a candidate is only
+// eligible if it reproduces the built-in profile's output on every full-size view
+
+#define TUNE_RUNS 2
+#define TUNE_SCALE 2
+
+static const int tileSizes[] = { 16, 32, 64, 128, 256 };
+static const int minimumBlocks[] = { 3, 4, 6, 8, 12, 16 };
+
+#define TILE_SIZE_COUNT (int)(sizeof tileSizes / sizeof tileSizes[0])
+#define MINIMUM_BLOCK_COUNT (int)(sizeof minimumBlocks / sizeof minimumBlocks[0])
+
+// total fastGenerate time over the catalogue with this profile, in milliseconds
+static double measureProfile(const mandelbrotProfile *profile);
+
+// whether fastGenerate with this profile reproduces references (one per view)
+// bit for bit; NULL references are filled in from this profile instead
+static bool isOutputIdentical(const mandelbrotProfile *profile, int **references);
+static double millisecondsSince(const struct timespec *start);
+
+int main(int argc, char *argv[]) {
+   int index;
+   double milliseconds, bestMilliseconds, defaultMilliseconds;
+   mandelbrotProfile profile, best;
+   int *references[benchViewCount];
+
+   if (argc < 2) {
+      fprintf(stderr, "usage: %s profile\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   MandelbrotSet_getProfile(&best);
+
+   for (index = 0; index != benchViewCount; ++index) {
+      references[index] = NULL;
+   }
+   isOutputIdentical(&best, references);
+
+   // a throwaway pass so the defaults aren't penalised for warming up the machine
+   measureProfile(&best);
+   defaultMilliseconds = measureProfile(&best);
+   bestMilliseconds = defaultMilliseconds;
+   fprintf(stderr, "defaults tileSize=%d minimumBlock=%d: %.1f ms\n",
+           best.tileSize, best.minimumBlock, defaultMilliseconds);
+
+   for (index = 0; index != TILE_SIZE_COUNT; ++index) {
+      profile = best;
+      profile.tileSize = tileSizes[index];
+      if (profile.minimumBlock > profile.tileSize) {
+         continue;
+      }
+
+      if (!isOutputIdentical(&profile, references)) {
+         fprintf(stderr, "tileSize=%d: output differs, rejected\n", profile.tileSize);
+         continue;
+      }
+
+      milliseconds = measureProfile(&profile);
+      fprintf(stderr, "tileSize=%d: %.1f ms\n", profile.tileSize, milliseconds);
+      if (milliseconds < bestMilliseconds) {
+         bestMilliseconds = milliseconds;
+         best = profile;
+      }
+   }
+
+   for (index = 0; index != MINIMUM_BLOCK_COUNT; ++index) {
+      profile = best;
+      profile.minimumBlock = minimumBlocks[index];
+      if (profile.minimumBlock > profile.tileSize) {
+         continue;
+      }
+
+      if (!isOutputIdentical(&profile, references)) {
+         fprintf(stderr, "minimumBlock=%d: output differs, rejected\n", profile.minimumBlock);
+         continue;
+      }
+
+      milliseconds = measureProfile(&profile);
+      fprintf(stderr, "minimumBlock=%d: %.1f ms\n", profile.minimumBlock, milliseconds);
+      if (milliseconds < bestMilliseconds) {
+         bestMilliseconds = milliseconds;
+         best = profile;
+      }
+   }
+
+   for (index = 0; index != benchViewCount; ++index) {
+      free(references[index]);
+   }
+
+   if (!MandelbrotSet_saveProfile(argv[1], &best)) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+   }
+   fprintf(stderr, "tileSize=%d minimumBlock=%d: %.1f ms (%.1f%% of defaults) -> %s\n",
+           best.tileSize, best.minimumBlock, bestMilliseconds,
+           100 * bestMilliseconds / defaultMilliseconds, argv[1]);
+
+   return EXIT_SUCCESS;
+}
+
+static double measureProfile(const mandelbrotProfile *profile) {
+   int index, run;
+   double milliseconds, fastest;
+   double total = 0;
+   benchView view;
+   MandelbrotSet fractal;
+   struct timespec start;
+
+   MandelbrotSet_setProfile(profile);
+
+   for (index = 0; index != benchViewCount; ++index) {
+      // the same region at the same resolution, just less of it
+      view = benchViews[index];
+      view.width /= TUNE_SCALE;
+      view.height /= TUNE_SCALE;
+      fractal = BenchViews_create(&view);
+
+      fastest = 0;
+      for (run = 0; run != TUNE_RUNS; ++run) {
+         MandelbrotSet_setPosition(fractal, view.center, view.zoom);
+
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         MandelbrotSet_fastGenerate(fractal);
+         milliseconds = millisecondsSince(&start);
+
+         if (run == 0 || milliseconds < fastest) {
+            fastest = milliseconds;
+         }
+      }
+      total += fastest;
+
+      freeMandelbrotSet(fractal);
+   }
+
+   return total;
+}
+
+static bool isOutputIdentical(const mandelbrotProfile *profile, int **references) {
+   int index;
+   size_t size;
+   bool isIdentical = true;
+   MandelbrotSet fractal;
+
+   MandelbrotSet_setProfile(profile);
+
+   // at full size, quartered views miss differences the whole view shows
+   for (index = 0; index != benchViewCount && isIdentical; ++index) {
+      fractal = BenchViews_create(&benchViews[index]);
+      MandelbrotSet_fastGenerate(fractal);
+
+      size = sizeof (int) * benchViews[index].width * benchViews[index].height;
+      if (references[index] == NULL) {
+         references[index] = malloc(size);
+         assert(references[index] != NULL);
+         memcpy(references[index], MandelbrotSet_getScores(fractal)[0], size);
+      } else {
+         isIdentical = (memcmp(references[index], MandelbrotSet_getScores(fractal)[0], size) == 0);
+      }
+
+      freeMandelbrotSet(fractal);
+   }
+
+   return isIdentical;
+}
+
+static double millisecondsSince(const struct timespec *start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "MandelbrotSet.h"
+#include "BenchViews.h"
+
+// Repeated timings of every benchmark view with both generators, saved as a
+// baseline or compared against one with 95% confidence intervals.
+//
+// usage: benchCompare save baseline.json [runs]
+//        benchCompare compare baseline.json [runs]
+//
+// compare exits with failure if any view and strategy is significantly slower:
+// the whole confidence interval of the difference in means lies above zero
+// and the slowdown exceeds SLOWDOWN_THRESHOLD, so it can gate kernel changes;
+// and if any has no baseline record, so a wrong or stale baseline can't pass it
+//
+// the baseline is a JSON array with one record per line, e.g.
+//    {"view": "overview", "strategy": "fast", "runs": 10, "meanMs": 25.3, "stddevMs": 0.41}
+
+#define DEFAULT_RUNS 10
+#define WARMUP_RUNS 2
+
+// ignore statistically significant but practically irrelevant differences
+#define SLOWDOWN_THRESHOLD 0.02
+
+#define STRATEGY_COUNT 2
+#define MAX_NAME 64
+
+typedef struct {
+   char view[MAX_NAME];
+   char strategy[MAX_NAME];
+   int runs;
+   double mean;
+   double stddev;
+} benchResult;
+
+static const char *strategyNames[STRATEGY_COUNT] = { "exact", "fast" };
+
+static void measure(const benchView *view, int strategy, int runs, benchResult *result);
+static bool saveResults(const char *path, const benchResult *results, int count);
+static int loadResults(const char *path, benchResult *results, int capacity);
+static const benchResult *findResult(const benchResult *results, int count, const benchResult *wanted);
+
+// returns true if current is significantly slower than baseline
+static bool compareResult(const benchResult *baseline, const benchResult *current);
+
+// two-sided 95% critical value of Student's t distribution
+static double criticalT(double degreesOfFreedom);
+
+static double millisecondsSince(const struct timespec *start);
+
+int main(int argc, char *argv[]) {
+   int index, strategy;
+   int runs = DEFAULT_RUNS;
+   int count = 0;
+   int baselineCount, slower = 0, missing = 0;
+   bool isSaving;
+   const benchResult *baseline;
+
+   if (argc < 3 || (strcmp(argv[1], "save") != 0 && strcmp(argv[1], "compare") != 0)) {
+      fprintf(stderr, "usage: %s save|compare baseline.json [runs]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   isSaving = (strcmp(argv[1], "save") == 0);
+   if (argc > 3) {
+      runs = atoi(argv[3]);
+   }
+   if (runs < 2) {
+      fprintf(stderr, "need at least 2 runs for a variance\n");
+      return EXIT_FAILURE;
+   }
+
+   benchResult *results = malloc(sizeof (benchResult) * benchViewCount * STRATEGY_COUNT);
+   benchResult *baselines = malloc(sizeof (benchResult) * benchViewCount * STRATEGY_COUNT);
+
+   baselineCount = 0;
+   if (!isSaving) {
+      baselineCount = loadResults(argv[2], baselines, benchViewCount * STRATEGY_COUNT);
+      if (baselineCount < 0) {
+         perror(argv[2]);
+         return EXIT_FAILURE;
+      }
+      if (baselineCount == 0) {
+         fprintf(stderr, "%s holds no baseline records\n", argv[2]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   for (index = 0; index != benchViewCount; ++index) {
+      for (strategy = 0; strategy != STRATEGY_COUNT; ++strategy) {
+         measure(&benchViews[index], strategy, runs, &results[count]);
+         fprintf(stderr, "%-10s %-6s %10.2f ms +- %.2f\n", results[count].view, results[count].strategy,
+                 results[count].mean, results[count].stddev);
+
+         if (!isSaving) {
+            baseline = findResult(baselines, baselineCount, &results[count]);
+            if (baseline == NULL) {
+               printf("%-10s %-6s not in baseline\n", results[count].view, results[count].strategy);
+               missing++;
+            } else if (compareResult(baseline, &results[count])) {
+               slower++;
+            }
+         }
+         count++;
+      }
+   }
+
+   if (isSaving && !saveResults(argv[2], results, count)) {
+      perror(argv[2]);
+      return EXIT_FAILURE;
+   }
+   if (!isSaving) {
+      printf("%d significant slowdown%s\n", slower, (slower == 1) ? "" : "s");
+      if (missing > 0) {
+         printf("%d not in baseline\n", missing);
+      }
+   }
+
+   free(baselines);
+   free(results);
+
+   return (slower == 0 && missing == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void measure(const benchView *view, int strategy, int runs, benchResult *result) {
+   int run;
+   double milliseconds;
+   double sum = 0;
+   double sumSquares = 0;
+   struct timespec start;
+
+   MandelbrotSet fractal = BenchViews_create(view);
+
+   // the first runs warm caches, page in the score block and let the clock settle
+   for (run = 0; run != WARMUP_RUNS + runs; ++run) {
+      MandelbrotSet_setPosition(fractal, view->center, view->zoom);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      if (strategy == 0) {
+         MandelbrotSet_generate(fractal);
+      } else {
+         MandelbrotSet_fastGenerate(fractal);
+      }
+      milliseconds = millisecondsSince(&start);
+
+      if (run >= WARMUP_RUNS) {
+         sum += milliseconds;
+         sumSquares += milliseconds * milliseconds;
+      }
+   }
+
+   freeMandelbrotSet(fractal);
+
+   snprintf(result->view, sizeof result->view, "%s", view->name);
+   snprintf(result->strategy, sizeof result->strategy, "%s", strategyNames[strategy]);
+   result->runs = runs;
+   result->mean = sum / runs;
+   // sample standard deviation
+   result->stddev = sqrt(fmax(0, (sumSquares - sum * sum / runs) / (runs - 1)));
+}
+
+static bool saveResults(const char *path, const benchResult *results, int count) {
+   int index;
+   bool isWritten;
+
+   FILE *file = fopen(path, "w");
+   if (file == NULL) {
+      return false;
+   }
+
+   fprintf(file, "[\n");
+   for (index = 0; index != count; ++index) {
+      fprintf(file, "{\"view\": \"%s\", \"strategy\": \"%s\", \"runs\": %d, \"meanMs\": %.4f, \"stddevMs\": %.4f}%s\n",
+              results[index].view, results[index].strategy, results[index].runs,
+              results[index].mean, results[index].stddev, (index + 1 == count) ? "" : ",");
+   }
+   fprintf(file, "]\n");
+
+   isWritten = !ferror(file);
+   isWritten = (fclose(file) == 0) && isWritten;
+
+   return isWritten;
+}
+
+static int loadResults(const char *path, benchResult *results, int capacity) {
+   char line[512];
+   int count = 0;
+   benchResult *result;
+
+   FILE *file = fopen(path, "r");
+   if (file == NULL) {
+      return -1;
+   }
+
+   // only reads what saveResults writes, lines that aren't records are skipped
+   while (count != capacity && fgets(line, sizeof line, file) != NULL) {
+      result = &results[count];
+      if (sscanf(line, " {\"view\": \"%63[^\"]\", \"strategy\": \"%63[^\"]\", \"runs\": %d, \"meanMs\": %lf, \"stddevMs\": %lf}",
+                 result->view, result->strategy, &result->runs, &result->mean, &result->stddev) == 5 &&
+          result->runs >= 2) {
+         count++;
+      }
+   }
+
+   fclose(file);
+   return count;
+}
+
+static const benchResult *findResult(const benchResult *results, int count, const benchResult *wanted) {
+   int index;
+
+   for (index = 0; index != count; ++index) {
+      if (strcmp(results[index].view, wanted->view) == 0 &&
+          strcmp(results[index].strategy, wanted->strategy) == 0) {
+         return &results[index];
+      }
+   }
+
+   return NULL;
+}
+
+static bool compareResult(const benchResult *baseline, const benchResult *current) {
+   // Welch's t-interval, the two runs needn't have the same variance or run count
+   double baselineVariance = baseline->stddev * baseline->stddev / baseline->runs;
+   double currentVariance = current->stddev * current->stddev / current->runs;
+   double standardError = sqrt(baselineVariance + currentVariance);
+   double degreesOfFreedom;
+   double difference = current->mean - baseline->mean;
+   double margin;
+   bool isSlower;
+
+   if (standardError > 0) {
+      degreesOfFreedom = (baselineVariance + currentVariance) * (baselineVariance + currentVariance) /
+                         (baselineVariance * baselineVariance / (baseline->runs - 1) +
+                          currentVariance * currentVariance / (current->runs - 1));
+   } else {
+      degreesOfFreedom = baseline->runs + current->runs - 2;
+   }
+   margin = criticalT(degreesOfFreedom) * standardError;
+
+   isSlower = (difference - margin > 0) && (difference > baseline->mean * SLOWDOWN_THRESHOLD);
+
+   printf("%-10s %-6s %9.2f -> %9.2f ms  %+6.1f%% [%+6.1f%%, %+6.1f%%]%s\n",
+          current->view, current->strategy, baseline->mean, current->mean,
+          100 * difference / baseline->mean,
+          100 * (difference - margin) / baseline->mean, 100 * (difference + margin) / baseline->mean,
+          isSlower ? "  SLOWER" : (difference + margin < 0) ? "  faster" : "");
+
+   return isSlower;
+}
+
+static double criticalT(double degreesOfFreedom) {
+   static const double table[] = {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+   };
+   // beyond the table, brackets starting at these degrees of freedom
+   static const int bracketStart[] = { 30, 40, 60, 120 };
+   static const double bracketT[] = { 2.042, 2.021, 2.000, 1.980 };
+   int rounded = (int)floor(degreesOfFreedom);
+   int bracket;
+
+   if (rounded < 1) {
+      rounded = 1;
+   }
+   if (rounded <= 30) {
+      // rounding down is conservative, fewer degrees of freedom give a wider interval
+      return table[rounded - 1];
+   }
+
+   // likewise the value at the bracket's lower end, never the narrower limit further in
+   bracket = (int)(sizeof bracketStart / sizeof bracketStart[0]) - 1;
+   while (rounded < bracketStart[bracket]) {
+      bracket--;
+   }
+   return bracketT[bracket];
+}
+
+static double millisecondsSince(const struct timespec *start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "MandelbrotSet.h"
+#include "BenchViews.h"
+#include "PerfCounters.h"
+
+// Times each generator on every benchmark view, with hardware counters
+// (cycles, instructions, branch and cache misses) when the host exposes them.
+//
+// usage: benchMandelbrotSet [view]     (default every view)
+//
+// uses the profile named by MANDELBROT_PROFILE, if set
+//
+// phases:
+//    escape    scoreAt on every pixel, the bare escape-time kernel
+//    generate  MandelbrotSet_generate
+//    fast      MandelbrotSet_fastGenerate (Mariani/Silver)
+
+typedef enum {
+   PHASE_ESCAPE,
+   PHASE_GENERATE,
+   PHASE_FAST_GENERATE,
+   PHASE_COUNT
+} benchPhase;
+
+static const char *phaseNames[PHASE_COUNT] = { "escape", "generate", "fast" };
+
+static void runPhase(MandelbrotSet fractal, const benchView *view, benchPhase phase);
+static void printResult(const benchView *view, benchPhase phase, double milliseconds,
+                        const perfReading *reading);
+static double millisecondsSince(const struct timespec *start);
+
+// keeps the escape phase from being optimised away
+static volatile long scoreSink;
+
+int main(int argc, char *argv[]) {
+   int index, phase;
+   int benchmarked = 0;
+   MandelbrotSet fractal;
+   struct timespec start;
+   double milliseconds;
+   perfReading reading;
+
+   // benchmark the tuned profile if there is one, as renders would use it
+   MandelbrotSet_loadProfile(NULL);
+
+   PerfCounters counters = createPerfCounters();
+   if (!PerfCounters_isAvailable(counters)) {
+      fprintf(stderr, "hardware counters unavailable (check perf_event_paranoid), timing only\n");
+   }
+
+   printf("%-10s %-9s %10s %14s %14s %6s %12s %12s\n",
+          "view", "phase", "ms", PerfCounters_getName(PERF_CYCLES), PerfCounters_getName(PERF_INSTRUCTIONS),
+          "IPC", PerfCounters_getName(PERF_BRANCH_MISSES), PerfCounters_getName(PERF_CACHE_MISSES));
+
+   for (index = 0; index != benchViewCount; ++index) {
+      if (argc > 1 && strcmp(argv[1], benchViews[index].name) != 0) {
+         continue;
+      }
+
+      fractal = BenchViews_create(&benchViews[index]);
+      for (phase = 0; phase != PHASE_COUNT; ++phase) {
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         PerfCounters_start(counters);
+         runPhase(fractal, &benchViews[index], phase);
+         PerfCounters_stop(counters, &reading);
+         milliseconds = millisecondsSince(&start);
+
+         printResult(&benchViews[index], phase, milliseconds, &reading);
+      }
+      freeMandelbrotSet(fractal);
+      benchmarked++;
+   }
+
+   freePerfCounters(counters);
+
+   if (benchmarked == 0) {
+      fprintf(stderr, "no view named %s\n", argv[1]);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
+
+static void runPhase(MandelbrotSet fractal, const benchView *view, benchPhase phase) {
+   int row, col;
+   long total = 0;
+   mandelbrotCoord coord;
+   real resolution = 1.0/((real)((unsigned long long)1 << view->zoom));
+   real left = view->center.x - (view->width  * resolution)/2.0;
+   real top  = view->center.y + (view->height * resolution)/2.0;
+
+   if (phase == PHASE_ESCAPE) {
+      for (row = 0; row != view->height; ++row) {
+         coord.y = top - (row + 0.5) * resolution;
+         for (col = 0; col != view->width; ++col) {
+            coord.x = left + (col + 0.5) * resolution;
+            total += MandelbrotSet_scoreAt(fractal, coord);
+         }
+      }
+      scoreSink = total;
+   } else if (phase == PHASE_GENERATE) {
+      MandelbrotSet_generate(fractal);
+   } else {
+      MandelbrotSet_fastGenerate(fractal);
+   }
+}
+
+static void printResult(const benchView *view, benchPhase phase, double milliseconds,
+                        const perfReading *reading) {
+   int counter;
+
+   printf("%-10s %-9s %10.1f", view->name, phaseNames[phase], milliseconds);
+
+   for (counter = 0; counter != PERF_COUNTER_COUNT; ++counter) {
+      if (!reading->isAvailable[counter]) {
+         printf(" %*s", (counter == PERF_BRANCH_MISSES || counter == PERF_CACHE_MISSES) ? 12 : 14, "-");
+      } else {
+         printf(" %*llu", (counter == PERF_BRANCH_MISSES || counter == PERF_CACHE_MISSES) ? 12 : 14,
+                reading->values[counter]);
+      }
+
+      if (counter == PERF_INSTRUCTIONS) {
+         if (reading->isAvailable[PERF_CYCLES] && reading->isAvailable[PERF_INSTRUCTIONS] &&
+             reading->values[PERF_CYCLES] > 0) {
+            printf(" %6.2f", (double)reading->values[PERF_INSTRUCTIONS] / reading->values[PERF_CYCLES]);
+         } else {
+            printf(" %6s", "-");
+         }
+      }
+   }
+   printf("\n");
+}
+
+static double millisecondsSince(const struct timespec *start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "Buddhabrot.h"
+
+// renders a classic Buddhabrot as a binary PGM on stdout
+// usage: demoBuddhabrot [millionsOfOrbits]
+
+#define WIDTH 800
+#define HEIGHT 800
+#define MIN_ITERATIONS 20
+#define MAX_ITERATIONS 2000
+
+int main(int argc, char *argv[]) {
+   int row, col;
+   long long orbits = 10000000;
+   uint32_t **density;
+   uint32_t maxDensity;
+   mandelbrotCoord center = { -0.4, 0.0 };
+
+   if (argc > 1) {
+      orbits = atoll(argv[1]) * 1000000;
+   }
+
+   // rotated the usual way, the set's axis running up the image
+   Buddhabrot buddhabrot = createBuddhabrot(WIDTH, HEIGHT, center, 3.0 / WIDTH);
+   Buddhabrot_setIterationRange(buddhabrot, MIN_ITERATIONS, MAX_ITERATIONS);
+   Buddhabrot_render(buddhabrot, MandelbrotPool_getDefault(), orbits, 1);
+
+   density = Buddhabrot_getDensity(buddhabrot);
+   maxDensity = Buddhabrot_getMaxDensity(buddhabrot);
+   fprintf(stderr, "sampled %.1f%% of the plane, peak density %u\n",
+           100 * Buddhabrot_getSampledFraction(buddhabrot), maxDensity);
+
+   printf("P5\n%d %d\n255\n", HEIGHT, WIDTH);
+   for (col = 0; col != WIDTH; ++col) {
+      for (row = 0; row != HEIGHT; ++row) {
+         // square root tone curve, the density spans orders of magnitude
+         putchar(maxDensity == 0 ? 0 : (int)(255 * sqrt((double)density[row][col] / maxDensity)));
+      }
+   }
+
+   freeBuddhabrot(buddhabrot);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CheckpointRender.h"
+
+// renders a large view to a score file, checkpointing every few seconds
+// run it again after killing it and it picks up where the checkpoint left off
+
+#define WORKERS 4
+#define CHECKPOINT_INTERVAL 5
+
+int main(int argc, char *argv[]) {
+   checkpointJob job;
+   bool isRendered;
+
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s output.scores checkpoint\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   memset(&job, 0, sizeof job);
+   job.center.x = -0.743643887037151;
+   job.center.y = 0.131825904205330;
+   job.zoom = 20;
+   job.width = 8192;
+   job.height = 8192;
+   job.tileSize = 256;
+   job.maxIterations = 5000;
+   snprintf(job.outputPath, sizeof job.outputPath, "%s", argv[1]);
+
+   RenderCluster cluster = createRenderCluster(WORKERS);
+
+   if (access(argv[2], F_OK) == 0) {
+      fprintf(stderr, "resuming from %s\n", argv[2]);
+      isRendered = CheckpointRender_resume(cluster, &job, argv[2], CHECKPOINT_INTERVAL);
+   } else {
+      isRendered = CheckpointRender_start(cluster, &job, argv[2], CHECKPOINT_INTERVAL);
+   }
+
+   freeRenderCluster(cluster);
+
+   if (!isRendered) {
+      fprintf(stderr, "render failed\n");
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "ExponentialMap.h"
+#include "FrameWriter.h"
+
+// renders one log-polar strip, then writes a 60 second YUV4MPEG2 zoom to stdout, e.g.
+//    ./demoExponentialZoom | ffmpeg -i - zoom.mp4
+
+#define MAX_ITERATIONS 1000
+#define FRAMES_PER_SECOND 60
+#define SECONDS 60
+
+int main(int argc, char *argv[]) {
+   int width = 640;
+   int height = 480;
+   int row;
+
+   mandelbrotCoord center = { -0.743643887037151, 0.131825904205330 };
+   real firstResolution = 1.0/128;
+   real lastResolution = 1.0/((real)(1ULL << 40));
+   real resolution;
+   int frameCount = SECONDS * FRAMES_PER_SECOND;
+   int frame;
+
+   // the strip has to reach the corners of the first frame and the center pixel of the last
+   real maxRadius = firstResolution * sqrtl(width*width + height*height) / 2.0;
+   real minRadius = lastResolution / 2.0;
+
+   signal(SIGPIPE, SIG_IGN);
+
+   ExponentialMap map = createExponentialMap(center, minRadius, maxRadius, (width * 9) / 2);
+   ExponentialMap_setMaxIterations(map, MAX_ITERATIONS);
+   ExponentialMap_render(map);
+
+   ExponentialResampler resampler = createExponentialResampler(map, width, height);
+
+   int **scores = malloc(sizeof (int *) * height);
+   for (row = 0; row != height; ++row) {
+      scores[row] = malloc(sizeof (int) * width);
+   }
+
+   FrameWriter writer = createFrameWriter(STDOUT_FILENO, width, height, FRAME_FORMAT_Y4M, FRAMES_PER_SECOND);
+
+   for (frame = 0; frame != frameCount; ++frame) {
+      resolution = firstResolution * powl(lastResolution / firstResolution, (real)frame / (frameCount - 1));
+      ExponentialResampler_renderFrame(resampler, resolution, scores);
+
+      if (!FrameWriter_writeScores(writer, scores, MAX_ITERATIONS)) {
+         fprintf(stderr, "output closed after frame %d\n", frame);
+         break;
+      }
+   }
+
+   freeFrameWriter(writer);
+
+   for (row = 0; row != height; ++row) {
+      free(scores[row]);
+   }
+   free(scores);
+
+   freeExponentialResampler(resampler);
+   freeExponentialMap(map);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "LatticeView.h"
+
+// renders two overlapping views as two users panning the same area would,
+// reports how many tiles the second could take from the cache and checks the
+// views agree wherever they overlap, then writes the second as a PGM on stdout
+
+#define WIDTH 640
+#define HEIGHT 480
+#define ZOOM 14
+#define CACHE_TILES 256
+
+int main(void) {
+   int row, col;
+   int mismatches = 0;
+   int **first, **second;
+   long long shiftX, shiftY;
+   mandelbrotCoord centerA = { -0.743643887037151, 0.131825904205330 };
+   mandelbrotCoord centerB = { -0.735000000000000, 0.125000000000000 };
+   mandelbrotCoord snappedA, snappedB;
+   real resolution = 1.0/((real)(1 << ZOOM));
+
+   TileCache cache = createTileCache(CACHE_TILES);
+   LatticeView viewA = createLatticeView(WIDTH, HEIGHT, cache, MandelbrotPool_getDefault(), 1000);
+   LatticeView viewB = createLatticeView(WIDTH, HEIGHT, cache, MandelbrotPool_getDefault(), 1000);
+
+   LatticeView_setPosition(viewA, centerA, ZOOM);
+   LatticeView_generate(viewA);
+   fprintf(stderr, "first view rendered %d tiles\n", LatticeView_getRenderCount(viewA));
+
+   LatticeView_setPosition(viewB, centerB, ZOOM);
+   LatticeView_generate(viewB);
+   fprintf(stderr, "second view rendered %d tiles\n", LatticeView_getRenderCount(viewB));
+
+   // both views sit on the lattice, so they are offset by whole pixels
+   snappedA = LatticeView_getCenter(viewA);
+   snappedB = LatticeView_getCenter(viewB);
+   shiftX = llroundl((snappedB.x - snappedA.x) / resolution);
+   shiftY = llroundl((snappedA.y - snappedB.y) / resolution);
+
+   first = LatticeView_getScores(viewA);
+   second = LatticeView_getScores(viewB);
+   for (row = 0; row != HEIGHT; ++row) {
+      for (col = 0; col != WIDTH; ++col) {
+         if (row + shiftY >= 0 && row + shiftY < HEIGHT && col + shiftX >= 0 && col + shiftX < WIDTH &&
+             first[row + shiftY][col + shiftX] != second[row][col]) {
+            mismatches++;
+         }
+      }
+   }
+   fprintf(stderr, "offset (%lld, %lld) pixels, %d overlapping pixels differ\n", shiftX, shiftY, mismatches);
+
+   printf("P5\n%d %d\n255\n", WIDTH, HEIGHT);
+   for (row = 0; row != HEIGHT; ++row) {
+      for (col = 0; col != WIDTH; ++col) {
+         putchar(second[row][col] % 256);
+      }
+   }
+
+   freeLatticeView(viewB);
+   freeLatticeView(viewA);
+   freeTileCache(cache);
+   return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "RenderCluster.h"
+
+// renders a viewport on local worker processes, writing each tile
+// into a binary PGM as it arrives rather than holding the whole image
+
+#define WORKERS 4
+#define TILE_SIZE 128
+
+typedef struct {
+   int fd;
+   int width;
+   off_t headerLength;
+   int maxIterations;
+   unsigned char *row;
+} pgmOutput;
+
+static void writeTile(const clusterTile *tile, int **scores, void *data) {
+   pgmOutput *output = data;
+   int row, col;
+   off_t offset;
+
+   for (row = 0; row != tile->height; ++row) {
+      for (col = 0; col != tile->width; ++col) {
+         output->row[col] = (unsigned char)((scores[row][col] * 255) / output->maxIterations);
+      }
+      offset = output->headerLength + (off_t)(tile->top + row) * output->width + tile->left;
+      if (pwrite(output->fd, output->row, tile->width, offset) != tile->width) {
+         perror("pwrite");
+         exit(EXIT_FAILURE);
+      }
+   }
+}
+
+int main(int argc, char *argv[]) {
+   int width = 1024;
+   int height = 768;
+
+   mandelbrotCoord center = { -0.5, 0.0 };
+   int zoom = 8;
+   int unrendered;
+
+   char header[64];
+   pgmOutput output;
+
+   if (argc < 2) {
+      fprintf(stderr, "usage: %s output.pgm\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   output.fd = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (output.fd < 0) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   snprintf(header, sizeof header, "P5\n%d %d\n255\n", width, height);
+   output.headerLength = strlen(header);
+   output.width = width;
+   output.maxIterations = DEFAULT_MAX_ITERATIONS;
+   output.row = malloc(TILE_SIZE);
+
+   if (write(output.fd, header, output.headerLength) != output.headerLength) {
+      perror("write");
+      return EXIT_FAILURE;
+   }
+
+   RenderCluster cluster = createRenderCluster(WORKERS);
+   unrendered = RenderCluster_renderViewport(cluster, center, zoom, width, height, TILE_SIZE, writeTile, &output);
+
+   fprintf(stderr, "%d worker restarts\n", RenderCluster_getRestartCount(cluster));
+   if (unrendered > 0) {
+      fprintf(stderr, "%d tiles failed to render\n", unrendered);
+   }
+   freeRenderCluster(cluster);
+
+   free(output.row);
+   close(output.fd);
+
+   return (unrendered == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Supersampler.h"
+
+// renders an anti-aliased view, 16 samples per pixel through a Lanczos filter
+// (or a box filter given "box"), and writes it as a PGM on stdout
+
+#define WIDTH 640
+#define HEIGHT 480
+#define FACTOR 4
+
+int main(int argc, char *argv[]) {
+   int row, col;
+   float **values;
+   mandelbrotCoord center = { -0.743643887037151, 0.131825904205330 };
+   supersampleFilter filter = (argc > 1 && strcmp(argv[1], "box") == 0) ? SUPERSAMPLE_BOX : SUPERSAMPLE_LANCZOS;
+
+   Supersampler supersampler = createSupersampler(WIDTH, HEIGHT, FACTOR, filter);
+   Supersampler_setMaxIterations(supersampler, 1000);
+   Supersampler_setView(supersampler, center, 1.0/(1 << 14));
+   Supersampler_render(supersampler, true);
+
+   values = Supersampler_getValues(supersampler);
+   printf("P5\n%d %d\n255\n", WIDTH, HEIGHT);
+   for (row = 0; row != HEIGHT; ++row) {
+      for (col = 0; col != WIDTH; ++col) {
+         putchar((int)values[row][col] % 256);
+      }
+   }
+
+   freeSupersampler(supersampler);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MandelbrotSet.h"
+
+// generates a view in short slices, as a single-threaded UI would between input events,
+// printing progress per slice to stderr and the finished view as a PGM on stdout
+
+#define WIDTH 640
+#define HEIGHT 480
+#define SLICE_MICROSECONDS 4000
+
+int main(void) {
+   int row, col;
+   int slices = 0;
+   int **scores;
+   mandelbrotCoord center = { -0.743643887037151, 0.131825904205330 };
+
+   MandelbrotSet fractal = createMandelbrotSet(WIDTH, HEIGHT);
+   MandelbrotSet_setMaxIterations(fractal, 1000);
+   MandelbrotSet_setPosition(fractal, center, 14);
+
+   MandelbrotSet_beginSteps(fractal, true);
+   while (!MandelbrotSet_step(fractal, 0, SLICE_MICROSECONDS)) {
+      // a real host would handle input and repaint the finished tiles here
+      slices++;
+      fprintf(stderr, "\rslice %d, %3.0f%% of tiles done", slices, 100 * MandelbrotSet_getStepProgress(fractal));
+   }
+   fprintf(stderr, "\rgenerated in %d slices of %d us\n", slices + 1, SLICE_MICROSECONDS);
+
+   scores = MandelbrotSet_getScores(fractal);
+   printf("P5\n%d %d\n255\n", WIDTH, HEIGHT);
+   for (row = 0; row != HEIGHT; ++row) {
+      for (col = 0; col != WIDTH; ++col) {
+         putchar(scores[row][col] % 256);
+      }
+   }
+
+   freeMandelbrotSet(fractal);
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "ZoomKeyframes.h"
+#include "FrameWriter.h"
+
+// writes a YUV4MPEG2 zoom interpolated between keyframes to stdout, e.g.
+//    ./demoZoomKeyframes | ffmpeg -i - zoom.mp4
+
+#define MAX_ITERATIONS 1000
+#define FRAMES_PER_SECOND 30
+
+// zoom steps covered, and frames per step
+#define FIRST_ZOOM 7
+#define LAST_ZOOM 40
+#define FRAMES_PER_ZOOM 15
+
+int main(int argc, char *argv[]) {
+   int width = 640;
+   int height = 480;
+
+   mandelbrotCoord center = { -0.743643887037151, 0.131825904205330 };
+   int frameCount = (LAST_ZOOM - FIRST_ZOOM) * FRAMES_PER_ZOOM;
+   int frame, row;
+   int **scores;
+
+   // let a closed pipe show up as a failed write rather than killing the process
+   signal(SIGPIPE, SIG_IGN);
+
+   scores = malloc(sizeof (int *) * height);
+   assert(scores != NULL);
+   scores[0] = malloc(sizeof (int) * width * height);
+   assert(scores[0] != NULL);
+   for (row = 1; row != height; ++row) {
+      scores[row] = scores[0] + (size_t)row * width;
+   }
+
+   ZoomKeyframes keyframes = createZoomKeyframes(width, height, center);
+   ZoomKeyframes_setMaxIterations(keyframes, MAX_ITERATIONS);
+
+   FrameWriter writer = createFrameWriter(STDOUT_FILENO, width, height, FRAME_FORMAT_Y4M, FRAMES_PER_SECOND);
+
+   for (frame = 0; frame != frameCount; ++frame) {
+      ZoomKeyframes_renderFrame(keyframes, FIRST_ZOOM + (real)frame / FRAMES_PER_ZOOM, scores);
+
+      if (!FrameWriter_writeScores(writer, scores, MAX_ITERATIONS)) {
+         fprintf(stderr, "output closed after frame %d\n", frame);
+         break;
+      }
+   }
+
+   fprintf(stderr, "%d frames from %d keyframes\n", frame, ZoomKeyframes_getRenderCount(keyframes));
+
+   freeFrameWriter(writer);
+   freeZoomKeyframes(keyframes);
+   free(scores[0]);
+   free(scores);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "MandelbrotAnimation.h"
+#include "FrameWriter.h"
+
+// writes a YUV4MPEG2 zoom to stdout, e.g.
+//    ./demoZoomVideo | ffmpeg -i - zoom.mp4
+
+#define MAX_ITERATIONS 1000
+#define FRAMES_PER_SECOND 30
+
+int main(int argc, char *argv[]) {
+   int width = 640;
+   int height = 480;
+
+   mandelbrotCoord center = { -0.743643887037151, 0.131825904205330 };
+   animationKeyframe path[] = {
+      { 0.0,  center, 1.0/128 },
+      { 20.0, center, 1.0/((real)(1ULL << 40)) }
+   };
+   int frameCount = 20 * FRAMES_PER_SECOND;
+   int frame;
+   int **scores;
+
+   // let a closed pipe show up as a failed write rather than killing the process
+   signal(SIGPIPE, SIG_IGN);
+
+   MandelbrotAnimation animation = createMandelbrotAnimation(width, height, path, 2);
+   MandelbrotAnimation_setMaxIterations(animation, MAX_ITERATIONS);
+
+   FrameWriter writer = createFrameWriter(STDOUT_FILENO, width, height, FRAME_FORMAT_Y4M, FRAMES_PER_SECOND);
+
+   for (frame = 0; frame != frameCount; ++frame) {
+      scores = MandelbrotAnimation_renderFrame(animation, (real)frame / FRAMES_PER_SECOND);
+
+      if (!FrameWriter_writeScores(writer, scores, MAX_ITERATIONS)) {
+         fprintf(stderr, "output closed after frame %d\n", frame);
+         break;
+      }
+   }
+
+   freeFrameWriter(writer);
+   freeMandelbrotAnimation(animation);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,26 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TilePyramid.h"
+
+int main(int argc, char *argv[]) {
+   int levels;
+   int maxIterations = DEFAULT_MAX_ITERATIONS;
+
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s archive levels [maxIterations]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   levels = atoi(argv[2]);
+   if (argc > 3) {
+      maxIterations = atoi(argv[3]);
+   }
+
+   if (!TilePyramid_writeArchive(argv[1], levels, maxIterations)) {
+      fprintf(stderr, "could not write %s\n", argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdbool.h>
+
+#include "../MandelbrotSet.h"
+
+// Python binding: mandelbrot.Renderer exposes its scores through the buffer protocol,
+// so numpy.asarray(renderer) is a (height, width) int32 view with no copy.
+// generate() releases the GIL, so renderers can run on several Python threads.
+
+typedef struct {
+   PyObject_HEAD
+   MandelbrotSet fractal;
+   int width;
+   int height;
+   // set while generate runs without the GIL, guards against concurrent use
+   bool isGenerating;
+   Py_ssize_t shape[2];
+   Py_ssize_t strides[2];
+} RendererObject;
+
+// Renderer.__new__ without __init__ (or a failed __init__) leaves no fractal
+static bool checkIdle(RendererObject *self) {
+   if (self->fractal == NULL) {
+      PyErr_SetString(PyExc_RuntimeError, "renderer is not initialised");
+      return false;
+   }
+   if (self->isGenerating) {
+      PyErr_SetString(PyExc_RuntimeError, "renderer is generating on another thread");
+      return false;
+   }
+   return true;
+}
+
+static int Renderer_init(RendererObject *self, PyObject *args, PyObject *kwargs) {
+   static char *keywords[] = { "width", "height", NULL };
+   int width, height;
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ii", keywords, &width, &height)) {
+      return -1;
+   }
+   if (width <= 0 || height <= 0) {
+      PyErr_SetString(PyExc_ValueError, "width and height must be positive");
+      return -1;
+   }
+   if (self->fractal != NULL) {
+      PyErr_SetString(PyExc_RuntimeError, "renderer is already initialised");
+      return -1;
+   }
+
+   self->fractal = createMandelbrotSet(width, height);
+   self->width = width;
+   self->height = height;
+   self->isGenerating = false;
+
+   self->shape[0] = height;
+   self->shape[1] = width;
+   self->strides[0] = sizeof (int) * width;
+   self->strides[1] = sizeof (int);
+
+   return 0;
+}
+
+static void Renderer_dealloc(RendererObject *self) {
+   // live buffer exports hold a reference, so no view can outlive the scores
+   if (self->fractal != NULL) {
+      freeMandelbrotSet(self->fractal);
+   }
+   Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *Renderer_setPosition(RendererObject *self, PyObject *args) {
+   mandelbrotCoord center;
+   double x, y;
+   int zoom;
+
+   if (!PyArg_ParseTuple(args, "ddi", &x, &y, &zoom) || !checkIdle(self)) {
+      return NULL;
+   }
+   if (zoom < 0 || zoom > 63) {
+      PyErr_SetString(PyExc_ValueError, "zoom must be between 0 and 63");
+      return NULL;
+   }
+
+   center.x = x;
+   center.y = y;
+   MandelbrotSet_setPosition(self->fractal, center, zoom);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *Renderer_setView(RendererObject *self, PyObject *args) {
+   mandelbrotCoord center;
+   double x, y, resolution;
+
+   if (!PyArg_ParseTuple(args, "ddd", &x, &y, &resolution) || !checkIdle(self)) {
+      return NULL;
+   }
+
+   center.x = x;
+   center.y = y;
+   MandelbrotSet_setView(self->fractal, center, resolution);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *Renderer_setRotatedView(RendererObject *self, PyObject *args) {
+   mandelbrotCoord center;
+   double x, y, resolution, radians;
+
+   if (!PyArg_ParseTuple(args, "dddd", &x, &y, &resolution, &radians) || !checkIdle(self)) {
+      return NULL;
+   }
+
+   center.x = x;
+   center.y = y;
+   MandelbrotSet_setRotatedView(self->fractal, center, resolution, radians);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *Renderer_setMaxIterations(RendererObject *self, PyObject *args) {
+   int maxIterations;
+
+   if (!PyArg_ParseTuple(args, "i", &maxIterations) || !checkIdle(self)) {
+      return NULL;
+   }
+
+   MandelbrotSet_setMaxIterations(self->fractal, maxIterations);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *Renderer_generate(RendererObject *self, PyObject *args, PyObject *kwargs) {
+   static char *keywords[] = { "fast", NULL };
+   int isFast = 1;
+   MandelbrotSet fractal = self->fractal;
+
+   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|p", keywords, &isFast) || !checkIdle(self)) {
+      return NULL;
+   }
+
+   self->isGenerating = true;
+   Py_BEGIN_ALLOW_THREADS
+   if (isFast) {
+      MandelbrotSet_fastGenerate(fractal);
+   } else {
+      MandelbrotSet_generate(fractal);
+   }
+   Py_END_ALLOW_THREADS
+   self->isGenerating = false;
+
+   Py_RETURN_NONE;
+}
+
+static int Renderer_getBuffer(RendererObject *self, Py_buffer *view, int flags) {
+   int **scores;
+
+   if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE) {
+      PyErr_SetString(PyExc_BufferError, "scores are read-only");
+      return -1;
+   }
+   if (self->fractal == NULL) {
+      PyErr_SetString(PyExc_BufferError, "renderer is not initialised");
+      return -1;
+   }
+   if (self->isGenerating) {
+      PyErr_SetString(PyExc_BufferError, "renderer is generating on another thread");
+      return -1;
+   }
+
+   scores = MandelbrotSet_getScores(self->fractal);
+   if (scores == NULL) {
+      PyErr_SetString(PyExc_BufferError, "scores require generating first");
+      return -1;
+   }
+
+   // the score block never moves, so the view stays valid (and sees later generates)
+   view->buf = scores[0];
+   view->obj = (PyObject *)self;
+   Py_INCREF(self);
+   view->len = (Py_ssize_t)sizeof (int) * self->width * self->height;
+   view->readonly = 1;
+   view->itemsize = sizeof (int);
+   view->format = ((flags & PyBUF_FORMAT) == PyBUF_FORMAT) ? "i" : NULL;
+   view->ndim = 2;
+   view->shape = ((flags & PyBUF_ND) == PyBUF_ND) ? self->shape : NULL;
+   view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : NULL;
+   view->suboffsets = NULL;
+   view->internal = NULL;
+
+   return 0;
+}
+
+static PyObject *Renderer_getWidth(RendererObject *self, void *closure) {
+   return PyLong_FromLong(self->width);
+}
+
+static PyObject *Renderer_getHeight(RendererObject *self, void *closure) {
+   return PyLong_FromLong(self->height);
+}
+
+static PyMethodDef Renderer_methods[] = {
+   { "set_position", (PyCFunction)Renderer_setPosition, METH_VARARGS,
+     "set_position(x, y, zoom): center the view, pixels 2**-zoom apart" },
+   { "set_view", (PyCFunction)Renderer_setView, METH_VARARGS,
+     "set_view(x, y, resolution): center the view, pixels resolution apart" },
+   { "set_rotated_view", (PyCFunction)Renderer_setRotatedView, METH_VARARGS,
+     "set_rotated_view(x, y, resolution, radians): as set_view, turned anticlockwise" },
+   { "set_max_iterations", (PyCFunction)Renderer_setMaxIterations, METH_VARARGS,
+     "set_max_iterations(n)" },
+   { "generate", (PyCFunction)(void (*)(void))Renderer_generate, METH_VARARGS | METH_KEYWORDS,
+     "generate(fast=True): render the view without holding the GIL" },
+   { NULL }
+};
+
+static PyGetSetDef Renderer_getset[] = {
+   { "width", (getter)Renderer_getWidth, NULL, "width in pixels", NULL },
+   { "height", (getter)Renderer_getHeight, NULL, "height in pixels", NULL },
+   { NULL }
+};
+
+static PyBufferProcs Renderer_buffer = {
+   (getbufferproc)Renderer_getBuffer,
+   NULL
+};
+
+static PyTypeObject RendererType = {
+   PyVarObject_HEAD_INIT(NULL, 0)
+   .tp_name = "mandelbrot.Renderer",
+   .tp_doc = "Renderer(width, height): scores are exposed through the buffer protocol",
+   .tp_basicsize = sizeof (RendererObject),
+   .tp_flags = Py_TPFLAGS_DEFAULT,
+   .tp_new = PyType_GenericNew,
+   .tp_init = (initproc)Renderer_init,
+   .tp_dealloc = (destructor)Renderer_dealloc,
+   .tp_methods = Renderer_methods,
+   .tp_getset = Renderer_getset,
+   .tp_as_buffer = &Renderer_buffer,
+};
+
+static struct PyModuleDef mandelbrotModule = {
+   PyModuleDef_HEAD_INIT,
+   .m_name = "mandelbrot",
+   .m_doc = "Mandelbrot set renderer with zero-copy score buffers",
+   .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_mandelbrot(void) {
+   PyObject *module;
+
+   if (PyType_Ready(&RendererType) < 0) {
+      return NULL;
+   }
+
+   module = PyModule_Create(&mandelbrotModule);
+   if (module == NULL) {
+      return NULL;
+   }
+
+   Py_INCREF(&RendererType);
+   if (PyModule_AddObject(module, "Renderer", (PyObject *)&RendererType) < 0) {
+      Py_DECREF(&RendererType);
+      Py_DECREF(module);
+      return NULL;
+   }
+
+   return module;
+}
@@ -0,0 +1,22 @@
+# Optional Python binding, build with:
+#    python setup.py build_ext --inplace
+#
+#    import numpy, mandelbrot
+#    renderer = mandelbrot.Renderer(640, 480)
+#    renderer.set_position(-0.5, 0.0, 8)
+#    renderer.generate()
+#    scores = numpy.asarray(renderer)   # (480, 640) int32, no copy
+
+from setuptools import Extension, setup
+
+setup(
+    name="mandelbrot",
+    version="0.1",
+    ext_modules=[
+        Extension(
+            "mandelbrot",
+            sources=["mandelbrotmodule.c", "../MandelbrotSet.c", "../Trace.c"],
+            extra_compile_args=["-std=gnu11"],
+        )
+    ],
+)
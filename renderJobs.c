@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "MandelbrotSet.h"
+#include "MandelbrotAsync.h"
+#include "MandelbrotPool.h"
+#include "Trace.h"
+
+// Batch renderer: runs every job in a manifest on one shared thread pool
+// and writes each as a binary PGM (16 bit when maxIterations exceeds 255).
+//
+// usage: renderJobs manifest [threads]     (manifest "-" reads stdin)
+//
+// one job per line, as key=value pairs; blank lines and # comments are ignored
+//    width=1920 height=1080 x=-0.5 y=0 zoom=9 iterations=1000 strategy=fast output=view.pgm
+//
+// zoom may be replaced by resolution (distance between pixel centers),
+// strategy is fast (Mariani/Silver) or exact, and defaults to fast
+//
+// set MANDELBROT_TRACE=trace.json to write a Chrome trace of every tile and pool thread,
+// and MANDELBROT_PROFILE to a profile written by autotune to use this machine's tuning
+
+#define MAX_LINE 4096
+#define MAX_PATH 1024
+
+typedef struct {
+   int line;
+   int width;
+   int height;
+   mandelbrotCoord center;
+   real resolution;
+   int maxIterations;
+   mandelbrotStrategy strategy;
+   char output[MAX_PATH];
+
+   double renderMilliseconds;
+   double writeMilliseconds;
+   bool isWritten;
+} renderJob;
+
+typedef struct {
+   pthread_mutex_t lock;
+   pthread_cond_t allDone;
+   int remaining;
+} jobBatch;
+
+typedef struct {
+   renderJob *job;
+   jobBatch *batch;
+} jobTask;
+
+static bool parseJob(char *line, renderJob *job);
+static void runJob(void *data);
+static bool writePgm(const char *path, int **scores, int width, int height, int maxIterations);
+static double millisecondsSince(const struct timespec *start);
+
+int main(int argc, char *argv[]) {
+   FILE *manifest;
+   char line[MAX_LINE];
+   char *content;
+   int lineNumber = 0;
+   int threads = 0;
+   int index;
+   int failed = 0;
+
+   renderJob *jobs = NULL;
+   int jobCount = 0;
+   int jobCapacity = 0;
+   jobBatch batch;
+   jobTask *tasks;
+   struct timespec start;
+   const char *tracePath = getenv("MANDELBROT_TRACE");
+
+   if (argc < 2) {
+      fprintf(stderr, "usage: %s manifest [threads]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   if (argc > 2) {
+      threads = atoi(argv[2]);
+   }
+
+   manifest = (strcmp(argv[1], "-") == 0) ? stdin : fopen(argv[1], "r");
+   if (manifest == NULL) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   // read and validate the whole manifest before rendering anything
+   while (fgets(line, sizeof line, manifest) != NULL) {
+      lineNumber++;
+
+      if (strchr(line, '\n') == NULL && !feof(manifest)) {
+         // the rest would be read as a job of its own
+         fprintf(stderr, "%s:%d: line longer than %d characters\n", argv[1], lineNumber, MAX_LINE - 2);
+         return EXIT_FAILURE;
+      }
+
+      content = line + strspn(line, " \t\r\n");
+      if (*content == '\0' || *content == '#') {
+         continue;
+      }
+
+      if (jobCount == jobCapacity) {
+         jobCapacity = (jobCapacity == 0) ? 16 : jobCapacity * 2;
+         jobs = realloc(jobs, sizeof (renderJob) * jobCapacity);
+         assert(jobs != NULL);
+      }
+
+      jobs[jobCount].line = lineNumber;
+      if (!parseJob(content, &jobs[jobCount])) {
+         fprintf(stderr, "%s:%d: invalid job\n", argv[1], lineNumber);
+         return EXIT_FAILURE;
+      }
+      jobCount++;
+   }
+
+   if (manifest != stdin) {
+      fclose(manifest);
+   }
+
+   if (tracePath != NULL) {
+      Trace_setEnabled(true);
+   }
+   if (getenv("MANDELBROT_PROFILE") != NULL && !MandelbrotSet_loadProfile(NULL)) {
+      fprintf(stderr, "ignoring unreadable profile %s\n", getenv("MANDELBROT_PROFILE"));
+   }
+
+   MandelbrotPool pool = (threads > 0) ? createMandelbrotPool(threads) : MandelbrotPool_getDefault();
+
+   pthread_mutex_init(&batch.lock, NULL);
+   pthread_cond_init(&batch.allDone, NULL);
+   batch.remaining = jobCount;
+
+   tasks = malloc(sizeof (jobTask) * (jobCount + 1));
+   assert(tasks != NULL);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (index = 0; index != jobCount; ++index) {
+      tasks[index].job = &jobs[index];
+      tasks[index].batch = &batch;
+      MandelbrotPool_submit(pool, runJob, &tasks[index]);
+   }
+
+   pthread_mutex_lock(&batch.lock);
+   while (batch.remaining > 0) {
+      pthread_cond_wait(&batch.allDone, &batch.lock);
+   }
+   pthread_mutex_unlock(&batch.lock);
+
+   for (index = 0; index != jobCount; ++index) {
+      fprintf(stderr, "line %d: %dx%d %s, render %.1f ms, write %.1f ms -> %s%s\n",
+              jobs[index].line, jobs[index].width, jobs[index].height,
+              (jobs[index].strategy == MANDELBROT_FAST_GENERATE) ? "fast" : "exact",
+              jobs[index].renderMilliseconds, jobs[index].writeMilliseconds,
+              jobs[index].output, jobs[index].isWritten ? "" : " (write failed)");
+      if (!jobs[index].isWritten) {
+         failed++;
+      }
+   }
+   fprintf(stderr, "%d jobs on %d threads in %.1f ms\n",
+           jobCount, MandelbrotPool_getThreadCount(pool), millisecondsSince(&start));
+
+   if (threads > 0) {
+      freeMandelbrotPool(pool);
+   }
+   if (tracePath != NULL && !Trace_write(tracePath)) {
+      perror(tracePath);
+      failed++;
+   }
+   pthread_cond_destroy(&batch.allDone);
+   pthread_mutex_destroy(&batch.lock);
+   free(tasks);
+   free(jobs);
+
+   return (failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static bool parseJob(char *line, renderJob *job) {
+   char *pair, *value, *end;
+   long zoom;
+   bool hasZoom = false;
+
+   job->width = 0;
+   job->height = 0;
+   job->center.x = 0;
+   job->center.y = 0;
+   job->resolution = 0;
+   job->maxIterations = DEFAULT_MAX_ITERATIONS;
+   job->strategy = MANDELBROT_FAST_GENERATE;
+   job->output[0] = '\0';
+
+   for (pair = strtok(line, " \t\r\n"); pair != NULL; pair = strtok(NULL, " \t\r\n")) {
+      value = strchr(pair, '=');
+      if (value == NULL || value[1] == '\0') {
+         // "width=" would otherwise parse as 0, or for x and y quietly as the origin
+         return false;
+      }
+      *value++ = '\0';
+
+      if (strcmp(pair, "width") == 0) {
+         job->width = (int)strtol(value, &end, 10);
+      } else if (strcmp(pair, "height") == 0) {
+         job->height = (int)strtol(value, &end, 10);
+      } else if (strcmp(pair, "x") == 0) {
+         job->center.x = strtold(value, &end);
+      } else if (strcmp(pair, "y") == 0) {
+         job->center.y = strtold(value, &end);
+      } else if (strcmp(pair, "zoom") == 0) {
+         zoom = strtol(value, &end, 10);
+         if (zoom < 0 || zoom > 63) {
+            return false;
+         }
+         job->resolution = 1.0/((real)((unsigned long long)1 << zoom));
+         hasZoom = true;
+      } else if (strcmp(pair, "resolution") == 0) {
+         job->resolution = strtold(value, &end);
+         hasZoom = true;
+      } else if (strcmp(pair, "iterations") == 0) {
+         job->maxIterations = (int)strtol(value, &end, 10);
+      } else if (strcmp(pair, "strategy") == 0) {
+         if (strcmp(value, "fast") == 0) {
+            job->strategy = MANDELBROT_FAST_GENERATE;
+         } else if (strcmp(value, "exact") == 0) {
+            job->strategy = MANDELBROT_GENERATE;
+         } else {
+            return false;
+         }
+         end = value + strlen(value);
+      } else if (strcmp(pair, "output") == 0) {
+         snprintf(job->output, sizeof job->output, "%s", value);
+         end = value + strlen(value);
+      } else {
+         return false;
+      }
+
+      if (*end != '\0') {
+         return false;
+      }
+   }
+
+   return job->width > 0 && job->height > 0 && hasZoom && job->resolution > 0 &&
+          job->maxIterations > 0 && job->output[0] != '\0';
+}
+
+static void runJob(void *data) {
+   jobTask *task = data;
+   renderJob *job = task->job;
+   struct timespec start;
+
+   // each job only holds its scores while it runs, so memory scales with threads, not jobs
+   MandelbrotSet fractal = createMandelbrotSet(job->width, job->height);
+   MandelbrotSet_setMaxIterations(fractal, job->maxIterations);
+   MandelbrotSet_setView(fractal, job->center, job->resolution);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   if (job->strategy == MANDELBROT_GENERATE) {
+      MandelbrotSet_generate(fractal);
+   } else {
+      MandelbrotSet_fastGenerate(fractal);
+   }
+   job->renderMilliseconds = millisecondsSince(&start);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   job->isWritten = writePgm(job->output, MandelbrotSet_getScores(fractal),
+                             job->width, job->height, job->maxIterations);
+   job->writeMilliseconds = millisecondsSince(&start);
+
+   freeMandelbrotSet(fractal);
+
+   pthread_mutex_lock(&task->batch->lock);
+   task->batch->remaining--;
+   if (task->batch->remaining == 0) {
+      pthread_cond_signal(&task->batch->allDone);
+   }
+   pthread_mutex_unlock(&task->batch->lock);
+}
+
+static bool writePgm(const char *path, int **scores, int width, int height, int maxIterations) {
+   int row, col;
+   int maxValue = (maxIterations > 65535) ? 65535 : maxIterations;
+   int bytesPerSample = (maxValue > 255) ? 2 : 1;
+   unsigned char *buffer;
+   long value;
+   bool isWritten;
+
+   FILE *file = fopen(path, "wb");
+   if (file == NULL) {
+      return false;
+   }
+
+   buffer = malloc((size_t)width * bytesPerSample);
+   assert(buffer != NULL);
+   fprintf(file, "P5\n%d %d\n%d\n", width, height, maxValue);
+
+   for (row = 0; row != height; ++row) {
+      for (col = 0; col != width; ++col) {
+         // rescale only when the score range does not fit in 16 bits
+         value = (maxValue == maxIterations) ? scores[row][col]
+                                             : ((long)scores[row][col] * maxValue) / maxIterations;
+         if (bytesPerSample == 2) {
+            // PGM samples wider than a byte are big-endian
+            buffer[2*col]   = (unsigned char)(value >> 8);
+            buffer[2*col+1] = (unsigned char)(value & 0xff);
+         } else {
+            buffer[col] = (unsigned char)value;
+         }
+      }
+      fwrite(buffer, bytesPerSample, width, file);
+   }
+
+   free(buffer);
+   isWritten = !ferror(file);
+   isWritten = (fclose(file) == 0) && isWritten;
+
+   return isWritten;
+}
+
+static double millisecondsSince(const struct timespec *start) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
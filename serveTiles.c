@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "TileArchive.h"
+#include "TileServer.h"
+#include "TileCache.h"
+#include "MandelbrotPool.h"
+
+// serves an archive, rendering (and prefetching) any tile it lacks
+// usage: serveTiles archive|- port [maxIterations [maxLevel]]    ("-" renders everything)
+// maxIterations defaults to the archive's, and must match it if given
+
+#define LISTEN_BACKLOG 64
+
+// rendered tiles kept in memory, each a few kilobytes encoded
+#define CACHE_TILES 4096
+#define DEFAULT_MAX_LEVEL 24
+
+int main(int argc, char *argv[]) {
+   struct sockaddr_in address;
+   int listenFd;
+   int reuse = 1;
+   int maxIterations = -1;
+   int maxLevel = DEFAULT_MAX_LEVEL;
+   TileArchive archive = NULL;
+
+   if (argc < 3) {
+      fprintf(stderr, "usage: %s archive|- port [maxIterations [maxLevel]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+   if (argc > 3) {
+      maxIterations = atoi(argv[3]);
+   }
+   if (argc > 4) {
+      maxLevel = atoi(argv[4]);
+   }
+
+   if (strcmp(argv[1], "-") != 0) {
+      archive = openTileArchive(argv[1]);
+      if (archive == NULL) {
+         fprintf(stderr, "could not open archive %s\n", argv[1]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   if (maxIterations < 0) {
+      maxIterations = (archive != NULL) ? TileArchive_getMaxIterations(archive) : DEFAULT_MAX_ITERATIONS;
+   }
+
+   listenFd = socket(AF_INET, SOCK_STREAM, 0);
+   setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+   memset(&address, 0, sizeof address);
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_ANY);
+   address.sin_port = htons(atoi(argv[2]));
+
+   if (bind(listenFd, (struct sockaddr *)&address, sizeof address) != 0 ||
+       listen(listenFd, LISTEN_BACKLOG) != 0) {
+      perror("listen");
+      return EXIT_FAILURE;
+   }
+
+   TileCache cache = createTileCache(CACHE_TILES);
+   TileServer server = createTileServer(archive);
+   if (!TileServer_enableRendering(server, cache, MandelbrotPool_getDefault(), maxIterations, maxLevel)) {
+      fprintf(stderr, "%s was rendered with maxIterations %d, not %d\n",
+              argv[1], TileArchive_getMaxIterations(archive), maxIterations);
+      return EXIT_FAILURE;
+   }
+   bool isRun = TileServer_run(server, listenFd);
+
+   freeTileServer(server);
+   freeTileCache(cache);
+   if (archive != NULL) {
+      closeTileArchive(archive);
+   }
+
+   return isRun ? EXIT_SUCCESS : EXIT_FAILURE;
+}
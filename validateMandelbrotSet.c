@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "MandelbrotSet.h"
+#include "BenchViews.h"
+#include "RenderCluster.h"
+
+// Differential validation of every fast path against MandelbrotSet_generate,
+// the long double pixel-by-pixel reference, on each benchmark view.
+//
+// usage: validateMandelbrotSet [errorDir] [view]
+//
+// for each view and path prints the mismatched pixel count, the largest score
+// error and where it is; with errorDir, writes <view>-<path>.pgm per path with
+// mismatches lit in proportion to their error (matching pixels are black)
+//
+// paths:
+//    fast       fastGenerate (Mariani/Silver boundary tracing)
+//    reproject  reprojected from the same view a zoom level out, as animation frames are
+//    tiled      assembled from VALIDATE_TILE_SIZE tiles rendered separately, as the cluster does
+//    scoreAt    the escape kernel called directly per pixel center
+//    rotFast    fastGenerate of the view turned by VALIDATE_ROTATION, against generate turned alike
+//    rotReproj  reproject, as above, from the turned view a zoom level out
+//    rotZero    generate through setRotatedView by 0 radians, against the setView reference
+
+#define VALIDATE_TILE_SIZE 96
+#define VALIDATE_ROTATION 0.5
+#define MAX_PATH 1024
+
+typedef enum {
+   PATH_FAST,
+   PATH_REPROJECT,
+   PATH_TILED,
+   PATH_SCORE_AT,
+   PATH_ROTATED_FAST,
+   PATH_ROTATED_REPROJECT,
+   PATH_ZERO_ROTATION,
+   PATH_COUNT
+} validationPath;
+
+static const char *pathNames[PATH_COUNT] = { "fast", "reproject", "tiled", "scoreAt",
+                                             "rotFast", "rotReproj", "rotZero" };
+
+// checked against the reference turned by VALIDATE_ROTATION rather than the plain one
+static const bool isPathRotated[PATH_COUNT] = { false, false, false, false, true, true, false };
+
+typedef struct {
+   long mismatches;
+   int maxError;
+   int maxErrorRow;
+   int maxErrorCol;
+} validationResult;
+
+// render the view through one path into scores (width * height, row by row)
+static void renderPath(const benchView *view, validationPath path, int *scores);
+
+static void compareScores(const benchView *view, const int *reference, const int *scores,
+                          validationResult *result);
+static bool writeErrorImage(const char *path, const benchView *view, const int *reference,
+                            const int *scores, int maxError);
+static void copyScores(MandelbrotSet fractal, int *scores, int width, int height);
+
+// a fractal sized for the view, turned by radians about its center
+static MandelbrotSet createRotated(const benchView *view, int zoom, real radians);
+
+int main(int argc, char *argv[]) {
+   int index, path;
+   int validated = 0;
+   const char *errorDir = (argc > 1) ? argv[1] : NULL;
+   char imagePath[MAX_PATH];
+   const benchView *view;
+   validationResult result;
+   int *reference, *rotatedReference, *scores;
+   MandelbrotSet fractal;
+
+   printf("%-10s %-10s %10s %9s %9s %s\n", "view", "path", "mismatches", "percent", "maxError", "at (row, col)");
+
+   for (index = 0; index != benchViewCount; ++index) {
+      view = &benchViews[index];
+      if (argc > 2 && strcmp(argv[2], view->name) != 0) {
+         continue;
+      }
+
+      reference = malloc(sizeof (int) * view->width * view->height);
+      rotatedReference = malloc(sizeof (int) * view->width * view->height);
+      scores = malloc(sizeof (int) * view->width * view->height);
+      assert(reference != NULL && rotatedReference != NULL && scores != NULL);
+
+      fractal = BenchViews_create(view);
+      MandelbrotSet_generate(fractal);
+      copyScores(fractal, reference, view->width, view->height);
+      freeMandelbrotSet(fractal);
+
+      fractal = createRotated(view, view->zoom, VALIDATE_ROTATION);
+      MandelbrotSet_generate(fractal);
+      copyScores(fractal, rotatedReference, view->width, view->height);
+      freeMandelbrotSet(fractal);
+
+      for (path = 0; path != PATH_COUNT; ++path) {
+         renderPath(view, path, scores);
+         compareScores(view, isPathRotated[path] ? rotatedReference : reference, scores, &result);
+
+         printf("%-10s %-10s %10ld %8.4f%% %9d", view->name, pathNames[path], result.mismatches,
+                100.0 * result.mismatches / ((long)view->width * view->height), result.maxError);
+         if (result.mismatches > 0) {
+            printf(" (%d, %d)", result.maxErrorRow, result.maxErrorCol);
+         }
+         printf("\n");
+
+         if (errorDir != NULL) {
+            snprintf(imagePath, sizeof imagePath, "%s/%s-%s.pgm", errorDir, view->name, pathNames[path]);
+            if (!writeErrorImage(imagePath, view, isPathRotated[path] ? rotatedReference : reference,
+                                 scores, result.maxError)) {
+               perror(imagePath);
+               return EXIT_FAILURE;
+            }
+         }
+      }
+
+      free(scores);
+      free(rotatedReference);
+      free(reference);
+      validated++;
+   }
+
+   if (validated == 0) {
+      fprintf(stderr, "no view named %s\n", argv[2]);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
+
+static void renderPath(const benchView *view, validationPath path, int *scores) {
+   int row, col, tile, tileCount, tileRow;
+   real resolution, left, top;
+   mandelbrotCoord coord;
+   clusterTile *tiles;
+   MandelbrotSet fractal, previous;
+   int **tileScores;
+
+   if (path == PATH_FAST) {
+      fractal = BenchViews_create(view);
+      MandelbrotSet_fastGenerate(fractal);
+      copyScores(fractal, scores, view->width, view->height);
+      freeMandelbrotSet(fractal);
+
+   } else if (path == PATH_REPROJECT) {
+      previous = createMandelbrotSet(view->width, view->height);
+      MandelbrotSet_setMaxIterations(previous, view->maxIterations);
+      MandelbrotSet_setPosition(previous, view->center, view->zoom - 1);
+      MandelbrotSet_generate(previous);
+
+      fractal = BenchViews_create(view);
+      MandelbrotSet_reproject(fractal, previous);
+      copyScores(fractal, scores, view->width, view->height);
+      freeMandelbrotSet(fractal);
+      freeMandelbrotSet(previous);
+
+   } else if (path == PATH_TILED) {
+      tileCount = RenderCluster_splitViewport(view->center, view->zoom, view->width, view->height,
+                                              VALIDATE_TILE_SIZE, &tiles);
+      for (tile = 0; tile != tileCount; ++tile) {
+         fractal = createMandelbrotSet(tiles[tile].width, tiles[tile].height);
+         MandelbrotSet_setMaxIterations(fractal, view->maxIterations);
+         MandelbrotSet_setPosition(fractal, tiles[tile].center, tiles[tile].zoom);
+         MandelbrotSet_generate(fractal);
+
+         tileScores = MandelbrotSet_getScores(fractal);
+         for (tileRow = 0; tileRow != tiles[tile].height; ++tileRow) {
+            memcpy(&scores[(size_t)(tiles[tile].top + tileRow) * view->width + tiles[tile].left],
+                   tileScores[tileRow], sizeof (int) * tiles[tile].width);
+         }
+         freeMandelbrotSet(fractal);
+      }
+      free(tiles);
+
+   } else if (path == PATH_ROTATED_FAST) {
+      fractal = createRotated(view, view->zoom, VALIDATE_ROTATION);
+      MandelbrotSet_fastGenerate(fractal);
+      copyScores(fractal, scores, view->width, view->height);
+      freeMandelbrotSet(fractal);
+
+   } else if (path == PATH_ROTATED_REPROJECT) {
+      previous = createRotated(view, view->zoom - 1, VALIDATE_ROTATION);
+      MandelbrotSet_generate(previous);
+
+      fractal = createRotated(view, view->zoom, VALIDATE_ROTATION);
+      MandelbrotSet_reproject(fractal, previous);
+      copyScores(fractal, scores, view->width, view->height);
+      freeMandelbrotSet(fractal);
+      freeMandelbrotSet(previous);
+
+   } else if (path == PATH_ZERO_ROTATION) {
+      fractal = createRotated(view, view->zoom, 0);
+      MandelbrotSet_generate(fractal);
+      copyScores(fractal, scores, view->width, view->height);
+      freeMandelbrotSet(fractal);
+
+   } else {
+      fractal = BenchViews_create(view);
+      resolution = 1.0/((real)((unsigned long long)1 << view->zoom));
+      left = view->center.x - (view->width  * resolution)/2.0;
+      top  = view->center.y + (view->height * resolution)/2.0;
+
+      for (row = 0; row != view->height; ++row) {
+         coord.y = top - (row + 0.5) * resolution;
+         for (col = 0; col != view->width; ++col) {
+            coord.x = left + (col + 0.5) * resolution;
+            scores[(size_t)row * view->width + col] = MandelbrotSet_scoreAt(fractal, coord);
+         }
+      }
+      freeMandelbrotSet(fractal);
+   }
+}
+
+static void compareScores(const benchView *view, const int *reference, const int *scores,
+                          validationResult *result) {
+   int row, col, error;
+   size_t index;
+
+   result->mismatches = 0;
+   result->maxError = 0;
+   result->maxErrorRow = 0;
+   result->maxErrorCol = 0;
+
+   for (row = 0; row != view->height; ++row) {
+      for (col = 0; col != view->width; ++col) {
+         index = (size_t)row * view->width + col;
+         error = abs(scores[index] - reference[index]);
+         if (error != 0) {
+            result->mismatches++;
+            if (error > result->maxError) {
+               result->maxError = error;
+               result->maxErrorRow = row;
+               result->maxErrorCol = col;
+            }
+         }
+      }
+   }
+}
+
+static bool writeErrorImage(const char *path, const benchView *view, const int *reference,
+                            const int *scores, int maxError) {
+   int row, col, error;
+   size_t index;
+   unsigned char *buffer;
+   bool isWritten;
+
+   FILE *file = fopen(path, "wb");
+   if (file == NULL) {
+      return false;
+   }
+
+   buffer = malloc(view->width);
+   assert(buffer != NULL);
+   fprintf(file, "P5\n%d %d\n255\n", view->width, view->height);
+
+   for (row = 0; row != view->height; ++row) {
+      for (col = 0; col != view->width; ++col) {
+         index = (size_t)row * view->width + col;
+         error = abs(scores[index] - reference[index]);
+         // even the smallest error stays visible against the black background
+         buffer[col] = (error == 0) ? 0 : (unsigned char)(64 + (191L * error) / maxError);
+      }
+      fwrite(buffer, 1, view->width, file);
+   }
+
+   free(buffer);
+   isWritten = !ferror(file);
+   isWritten = (fclose(file) == 0) && isWritten;
+
+   return isWritten;
+}
+
+static void copyScores(MandelbrotSet fractal, int *scores, int width, int height) {
+   // rows are contiguous, so the whole grid is one block
+   memcpy(scores, MandelbrotSet_getScores(fractal)[0], sizeof (int) * width * height);
+}
+
+static MandelbrotSet createRotated(const benchView *view, int zoom, real radians) {
+   MandelbrotSet fractal = createMandelbrotSet(view->width, view->height);
+   MandelbrotSet_setMaxIterations(fractal, view->maxIterations);
+   MandelbrotSet_setRotatedView(fractal, view->center, 1.0/((real)((unsigned long long)1 << zoom)), radians);
+
+   return fractal;
+}